@@ -12,7 +12,7 @@ __BEGIN_SYS
 
 class ARMv8_A_PMU;
 
-class PMU
+class PMU: public PMU_Common
 {
     friend class CPU;
 
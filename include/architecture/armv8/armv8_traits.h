@@ -13,6 +13,8 @@ template<> struct Traits<CPU>: public Traits<Build>
     static const unsigned int WORD_SIZE         = 64;
     static const unsigned int CLOCK             = Traits<Build>::MODEL == Traits<Build>::Raspberry_Pi3 ? 600000000 : 0;
     static const bool unaligned_memory_access   = false;
+    static const bool simd                      = false; // use NEON in memcpy() and memset(), requires the FPU context to be saved
+    static const bool crypto                    = false; // Cryptographic Extension (AESE/AESD), optional in Cortex-A53 and absent in the Raspberry Pi 3
 };
 
 template<> struct Traits<MMU>: public Traits<Build>
@@ -94,7 +94,8 @@ public:
 
     // CR4 Flags
     enum {
-        CR4_PSE     = 1 << 8    // CR4 Performance Counter Enable
+        CR4_PSE     = 1 << 4,   // CR4 Page Size Extensions (4 MB pages)
+        CR4_PCE     = 1 << 8    // CR4 Performance Counter Enable
     };
 
     // Segment Flags
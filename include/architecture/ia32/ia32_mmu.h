@@ -18,6 +18,7 @@ private:
 
     static const bool colorful = Traits<MMU>::colorful;
     static const unsigned int COLORS = Traits<MMU>::COLORS;
+    static const bool superpages = Traits<MMU>::superpages && !colorful; // a 4 MB page spans all colors
     static const unsigned int RAM_BASE  = Memory_Map::RAM_BASE;
     static const unsigned int APP_LOW   = Memory_Map::APP_LOW;
     static const unsigned int APP_HIGH  = Memory_Map::APP_HIGH;
@@ -137,20 +138,30 @@ public:
         Chunk() {}
 
         Chunk(unsigned int bytes, Flags flags, Color color = WHITE)
-        : _from(0), _to(pages(bytes)), _pts(page_tables(_to - _from)), _flags(Page_Flags(flags)), _pt(calloc(_pts, WHITE)) {
-            if(_flags & Page_Flags::CT)
-                _pt->map_contiguous(_from, _to, _flags, color);
-            else
-                _pt->map(_from, _to, _flags, color);
+        : _from(0), _to(pages(bytes)), _pts(page_tables(_to - _from)), _flags(Page_Flags(flags)), _color(color), _pt(0) {
+            if(large(_to))
+                map_large(alloc_aligned(_to, PT_ENTRIES, color));
+            if(!_pt) {
+                _pt = calloc(_pts, WHITE);
+                if(_flags & Page_Flags::CT)
+                    _pt->map_contiguous(_from, _to, _flags, color);
+                else
+                    _pt->map(_from, _to, _flags, color);
+            }
         }
 
         Chunk(Phy_Addr phy_addr, unsigned int bytes, Flags flags)
-        : _from(0), _to(pages(bytes)), _pts(page_tables(_to - _from)), _flags(Page_Flags(flags)), _pt(calloc(_pts, WHITE)) {
-            _pt->remap(phy_addr, _from, _to, flags);
+        : _from(0), _to(pages(bytes)), _pts(page_tables(_to - _from)), _flags(Page_Flags(flags)), _color(WHITE), _pt(0) {
+            if(large(_to) && (align_directory(phy_addr) == phy_addr))
+                map_large(phy_addr);
+            if(!_pt) {
+                _pt = calloc(_pts, WHITE);
+                _pt->remap(phy_addr, _from, _to, flags);
+            }
         }
 
         Chunk(Phy_Addr pt, unsigned int from, unsigned int to, Flags flags)
-        : _from(from), _to(to), _pts(page_tables(_to - _from)), _flags(flags), _pt(pt) {}
+        : _from(from), _to(to), _pts(page_tables(_to - _from)), _flags(flags), _color(WHITE), _pt(pt) {}
 
         ~Chunk() {
             if(!(_flags & Page_Flags::IO)) {
@@ -160,11 +171,12 @@ public:
                     for( ; _from < _to; _from++)
                         free((*_pt)[_from]);
             }
-            free(_pt, _pts);
+            free(_pt, (_flags & Page_Flags::PS) ? 1 : _pts);
         }
 
         unsigned int pts() const { return _pts; }
         Page_Flags flags() const { return _flags; }
+        Color color() const { return _color; }
         Page_Table * pt() const { return _pt; }
         unsigned int size() const { return (_to - _from) * sizeof(Page); }
 
@@ -178,29 +190,43 @@ public:
 
             unsigned int pgs = pages(amount);
 
-            Color color = colorful ? phy2color(_pt) : WHITE;
-
             unsigned int free_pgs = _pts * PT_ENTRIES - _to;
             if(free_pgs < pgs) { // resize _pt
                 unsigned int pts = _pts + page_tables(pgs - free_pgs);
-                Page_Table * pt = calloc(pts, color);
+                Page_Table * pt = calloc(pts, WHITE);
                 memcpy(phy2log(pt), phy2log(_pt), _pts * sizeof(Page));
                 free(_pt, _pts);
                 _pt = pt;
                 _pts = pts;
             }
 
-            _pt->map(_to, _to + pgs, _flags, color);
+            _pt->map(_to, _to + pgs, _flags, _color);
             _to += pgs;
 
             return pgs * sizeof(Page);
         }
 
+    private:
+        // Chunks spanning whole page directory entries are mapped with 4 MB pages (PDE.PS), whose PDEs are kept in _pt.
+        // Such chunks are contiguous, so, like other CT chunks, they can't grow (resize() returns 0). Segments that must
+        // grow should not be sized at multiples of 4 MB (or superpages should be disabled in Traits<MMU>)
+        static bool large(unsigned int pages) { return superpages && pages && !(pages % PT_ENTRIES); }
+
+        void map_large(Phy_Addr phy) {
+            if(!phy)
+                return;
+            _flags = _flags | Page_Flags::PS | Page_Flags::CT;
+            _pt = calloc(1, WHITE);
+            for(unsigned int i = 0; i < _pts; i++)
+                _pt->log()[i] = phy2pde(phy + i * PT_ENTRIES * sizeof(Page), _flags);
+        }
+
     private:
         unsigned int _from;
         unsigned int _to;
         unsigned int _pts;
         Page_Flags _flags;
+        Color _color;
         Page_Table * _pt; // this is a physical address
     };
 
@@ -245,7 +271,7 @@ public:
 
         void detach(const Chunk & chunk) {
             for(unsigned int i = 0; i < PD_ENTRIES; i++) {
-                if(indexes(pte2phy((*_pd)[i])) == indexes(chunk.pt())) {
+                if(indexes(pte2phy((*_pd)[i])) == key(chunk)) {
                     detach(i, chunk.pt(), chunk.pts());
                     return;
                 }
@@ -255,7 +281,7 @@ public:
 
         void detach(const Chunk & chunk, Log_Addr addr) {
             unsigned int from = directory(addr);
-            if(indexes(pte2phy((*_pd)[from])) != indexes(chunk.pt())) {
+            if(indexes(pte2phy((*_pd)[from])) != key(chunk)) {
                 db<MMU>(WRN) << "MMU::Directory::detach(pt=" << chunk.pt() << ",addr=" << addr << ") failed!" << endl;
                 return;
             }
@@ -264,6 +290,8 @@ public:
 
         Phy_Addr physical(Log_Addr addr) {
             PD_Entry pde = (*_pd)[directory(addr)];
+            if(pde & Page_Flags::PS)
+                return pde2phy(pde) | (addr & (PT_ENTRIES * sizeof(Page) - 1));
             Page_Table * pt = static_cast<Page_Table *>(pde2phy(pde));
             PT_Entry pte = pt->log()[page(addr)];
             return pte | offset(addr);
@@ -274,11 +302,20 @@ public:
             for(unsigned int i = from; i < from + n; i++)
                 if(_pd->log()[i])
                     return false;
-            for(unsigned int i = from; i < from + n; i++, pt++)
-                _pd->log()[i] = phy2pde(Phy_Addr(pt), flags);
+            if(flags & Page_Flags::PS) // 4 MB pages: the chunk holds the PDEs themselves
+                for(unsigned int i = from; i < from + n; i++)
+                    _pd->log()[i] = const_cast<Page_Table *>(pt)->log()[i - from];
+            else
+                for(unsigned int i = from; i < from + n; i++, pt++)
+                    _pd->log()[i] = phy2pde(Phy_Addr(pt), flags);
             return true;
         }
 
+        // What the first PDE of an attached chunk points to
+        static Phy_Addr key(const Chunk & chunk) {
+            return (chunk.flags() & Page_Flags::PS) ? Phy_Addr(indexes(chunk.pt()->log()[0])) : Phy_Addr(indexes(chunk.pt()));
+        }
+
         void detach(unsigned int from, const Page_Table * pt, unsigned int n) {
             for(unsigned int i = from; i < from + n; i++) {
                 _pd->log()[i] = 0;
@@ -328,6 +365,11 @@ public:
         friend OStream & operator<<(OStream & os, const Translation & t) {
             Page_Directory * pd = t._pd ? t._pd : current();
             PD_Entry pde = pd->log()[directory(t._addr)];
+            if(pde & Page_Flags::PS) {
+                os << "{addr=" << static_cast<void *>(t._addr) << ",pd=" << pd << ",pd[" << directory(t._addr) << "]=" << pde << "(4M)"
+                   << ",f=" << pde2phy(pde) << ",*addr=" << hex << *static_cast<unsigned int *>(t._addr) << "}";
+                return os;
+            }
             Page_Table * pt = static_cast<Page_Table *>(pde2phy(pde));
             PT_Entry pte = pt->log()[page(t._addr)];
 
@@ -351,7 +393,10 @@ public:
         Phy_Addr phy(false);
 
         if(frames) {
-            List::Element * e = _free[color].search_decrementing(frames);
+            List::Element * e = free_list(color).search_decrementing(frames);
+            if(colorful && !e && (color == WHITE) && (frames == 1)) // a single uncolored frame can be of any color
+                for(unsigned int c = 0; !e && (c < COLORS); c++)
+                    e = _free[c].search_decrementing(frames);
             if(e) {
                 phy = e->object() + e->size();
                 db<MMU>(TRC) << "MMU::alloc(frames=" << frames << ",color=" << color << ") => " << phy << endl;
@@ -365,6 +410,19 @@ public:
         return phy;
     }
 
+    // Allocates frames aligned to a multiple of "align" frames (a power of 2), giving the excess back to the free list
+    static Phy_Addr alloc_aligned(unsigned int frames, unsigned int align, Color color = WHITE) {
+        Phy_Addr phy = alloc(frames + align - 1, color);
+        if(phy) {
+            Phy_Addr aligned = (phy + (align - 1) * sizeof(Frame)) & ~(align * sizeof(Frame) - 1);
+            unsigned int head = (aligned - phy) / sizeof(Frame);
+            free(phy, head);
+            free(aligned + frames * sizeof(Frame), align - 1 - head);
+            phy = aligned;
+        }
+        return phy;
+    }
+
     static Phy_Addr calloc(unsigned int frames = 1, Color color = WHITE) {
         Phy_Addr phy = alloc(frames, color);
         memset(phy2log(phy), 0, sizeof(Frame) * frames);
@@ -378,10 +436,16 @@ public:
 
         db<MMU>(TRC) << "MMU::free(frame=" << frame << ",color=" << color << ",n=" << n << ")" << endl;
 
+        if(colorful && (n > 1)) { // each frame goes back to its own color
+            for(; n > 0; n--, frame += sizeof(Frame))
+                free(frame);
+            return;
+        }
+
         if(frame && n) {
             List::Element * e = new (phy2log(frame)) List::Element(frame, n);
             List::Element * m1, * m2;
-            _free[color].insert_merging(e, &m1, &m2);
+            free_list(color).insert_merging(e, &m1, &m2);
         }
     }
 
@@ -394,16 +458,19 @@ public:
         if(frame && n) {
             List::Element * e = new (phy2log(frame)) List::Element(frame, n);
             List::Element * m1, * m2;
-            _free[WHITE].insert_merging(e, &m1, &m2);
+            free_list(WHITE).insert_merging(e, &m1, &m2);
         }
     }
 
-    static unsigned int allocable(Color color = WHITE) { return _free[color].head() ? _free[color].head()->size() : 0; }
+    static unsigned int allocable(Color color = WHITE) { return free_list(color).head() ? free_list(color).head()->size() : 0; }
 
     static Page_Directory * volatile current() { return static_cast<Page_Directory * volatile>(pd()); }
 
     static Phy_Addr physical(Log_Addr addr) {
         Page_Directory * pd = current();
+        PD_Entry pde = pd->log()[directory(addr)];
+        if(pde & Page_Flags::PS)
+            return pde2phy(pde) | (addr & (PT_ENTRIES * sizeof(Page) - 1));
         Page_Table * pt = pd->log()[directory(addr)];
         return pt->log()[page(addr)] | offset(addr);
     }
@@ -418,17 +485,9 @@ public:
     static Log_Addr phy2log(Phy_Addr phy) { return Log_Addr((RAM_BASE == PHY_MEM) ? phy : (RAM_BASE > PHY_MEM) ? phy - (RAM_BASE - PHY_MEM) : phy + (PHY_MEM - RAM_BASE)); }
     static Phy_Addr log2phy(Log_Addr log) { return Phy_Addr((RAM_BASE == PHY_MEM) ? log : (RAM_BASE > PHY_MEM) ? log + (RAM_BASE - PHY_MEM) : log - (PHY_MEM - RAM_BASE)); }
 
-    static Color phy2color(Phy_Addr phy) { return static_cast<Color>(colorful ? ((phy >> PAGE_SHIFT) & 0x7f) % COLORS : WHITE); } // TODO: what is 0x7f
-
-    static Color log2color(Log_Addr log) {
-        if(colorful) {
-            Page_Directory * pd = current();
-            Page_Table * pt = pd->log()[directory(log)];
-            Phy_Addr phy = pt->log()[page(log)] | offset(log);
-            return static_cast<Color>(((phy >> PAGE_SHIFT) & 0x7f) % COLORS);
-        } else
-            return WHITE;
-    }
+    // The color of a frame is given by the LLC set index bits above the page offset (see Traits<MMU>::COLORS)
+    static Color phy2color(Phy_Addr phy) { return colorful ? static_cast<Color>((phy >> PAGE_SHIFT) % COLORS) : WHITE; }
+    static Color log2color(Log_Addr log) { return colorful ? phy2color(physical(log)) : WHITE; }
 
 private:
     static Phy_Addr pd() { return CPU::pd(); }
@@ -437,6 +496,9 @@ private:
     static void flush_tlb() { CPU::flush_tlb(); }
     static void flush_tlb(Log_Addr addr) { CPU::flush_tlb(addr); }
 
+    // Free frames of each color, followed by the uncolored (WHITE) ones, which is the only list without colorful
+    static List & free_list(Color color) { return _free[(colorful && (color != WHITE)) ? color % COLORS : colorful * COLORS]; }
+
     static void init();
 
 private:
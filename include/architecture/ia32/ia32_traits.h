@@ -22,7 +22,10 @@ template<> struct Traits<TSC>: public Traits<Build>
 template<> struct Traits<MMU>: public Traits<Build>
 {
     static const bool colorful = false;
-    static const unsigned int COLORS = 1;
+    static const unsigned int LLC_SIZE = 8 * 1024 * 1024; // last-level cache geometry (colors are derived from it)
+    static const unsigned int LLC_WAYS = 16;
+    static const unsigned int COLORS = (LLC_SIZE / LLC_WAYS / 4096 > 32) ? 32 : LLC_SIZE / LLC_WAYS / 4096; // page-sized LLC slices, up to the 32 Colors
+    static const bool superpages = true; // map suitably sized and aligned chunks with large pages
 };
 
 template<> struct Traits<FPU>: public Traits<Build>
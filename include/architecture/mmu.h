@@ -121,6 +121,7 @@ public:
 
         unsigned int pts() const { return 0; }
         Flags flags() const { return _flags; }
+        Color color() const { return WHITE; }
         Page_Table * pt() const { return 0; }
         unsigned int size() const { return _bytes; }
         Phy_Addr phy_address() const { return _phy_addr; } // always CT
@@ -35,7 +35,15 @@ public:
     static Hertz frequency() { return CLOCK; }
     static PPB accuracy() { return ACCURACY; }
 
-    static Time_Stamp time_stamp() { return (CPU::Reg64(reg(MTIMEH)) << 32) | reg(MTIME); }
+    // The upper half is read again to tell whether the lower one wrapped around in between
+    static Time_Stamp time_stamp() {
+        CPU::Reg32 hi, lo;
+        do {
+            hi = reg(MTIMEH);
+            lo = reg(MTIME);
+        } while(hi != reg(MTIMEH));
+        return (CPU::Reg64(hi) << 32) | lo;
+    }
 
 private:
     static void init() {}
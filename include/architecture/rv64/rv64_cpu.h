@@ -33,6 +33,9 @@ class CPU: protected CPU_Common
         SPP             = 1 <<  8,      // Supervisor Previous Privilege
         SPP_U           = 0 <<  8,      // Supervisor Previous Privilege = user
         SPP_S           = 1 <<  8,      // Supervisor Previous Privilege = supervisor
+        VS              = 3 <<  9,      // Vector Status
+        VS_OFF          = 0 <<  9,      // Vector unit off
+        VS_INIT         = 1 <<  9,      // Vector unit on
         MPP             = 3 << 11,      // Machine Previous Privilege
         MPP_U           = 0 << 11,      // Machine Previous Privilege = user
         MPP_S           = 1 << 11,      // Machine Previous Privilege = supervisor
@@ -99,7 +102,7 @@ class CPU: protected CPU_Common
         // Contexts are loaded with [m|s]ret, which gets pc from [m|s]epc and updates some bits of [m|s]status, that's why _st is initialized with [M|S]PIE and [M|S]PP
         // Kernel threads are created with usp = 0 and have SPP_S set
         // Dummy contexts for the first execution of each thread (both kernel and user) are created with exit = 0 and SPIE cleared (no interrupts until the second context is popped)
-        Context(Log_Addr entry, Log_Addr exit): _pc(entry), _st((exit ? MPIE : 0) | MPP_M), _x1(exit) {
+        Context(Log_Addr entry, Log_Addr exit): _pc(entry), _st((exit ? MPIE : 0) | MPP_M | (Traits<CPU>::vector ? VS_INIT : VS_OFF)), _x1(exit) {
             if(Traits<Build>::hysterically_debugged || Traits<Thread>::trace_idle) {
                                                                         _x5 =  5;  _x6 =  6;  _x7 =  7;  _x8 =  8;  _x9 =  9;
                 _x10 = 10; _x11 = 11; _x12 = 12; _x13 = 13; _x14 = 14; _x15 = 15; _x16 = 16; _x17 = 17; _x18 = 18; _x19 = 19;
@@ -299,6 +302,7 @@ public:
 
     static void flush_tlb() {         ASM("sfence.vma"    : :           : "memory"); }
     static void flush_tlb(Reg addr) { ASM("sfence.vma %0" : : "r"(addr) : "memory"); }
+    static void flush_tlb_asid(Reg asid) { ASM("sfence.vma zero, %0" : : "r"(asid) : "memory"); }
 
     using CPU_Common::htole64;
     using CPU_Common::htole32;
@@ -7,10 +7,615 @@
 #include <architecture/mmu.h>
 #undef __mmu_common_only__
 #include <system/memory_map.h>
+#include <utility/bitmap.h>
 
 __BEGIN_SYS
 
-class MMU: public No_MMU {};
+// Sv39 has three levels of 9 bits each. The two upper levels are handled here as a single 18-bit Directory whose
+// 512-entry slices (level 1 tables, each covering 1 GB) are allocated on demand. Chunks are therefore attached with
+// a 2 MB granularity, just like the 4 MB granularity of IA32's two-level paging. Chunks whose size is a multiple of
+// 2 MB (or 1 GB) are mapped with megapages (or gigapages), stored as leaves directly in level 1 (or root) entries.
+// EPOS still runs in machine mode on RISC-V, where satp has no effect, so the tables (and their ASIDs) only translate
+// for code running in supervisor or user mode. Until the kernel drops to supervisor mode, Address_Spaces keep their
+// mappings but isolate nothing, and there's no Task to switch them.
+class Sv39_MMU: public MMU_Common<18, 9, 12>
+{
+    friend class CPU;
+    friend class Setup;
+
+private:
+    typedef Grouping_List<Frame> List;
+
+    static const bool colorful = Traits<MMU>::colorful;
+    static const unsigned int COLORS = Traits<MMU>::COLORS;
+    static const bool superpages = Traits<MMU>::superpages && !colorful; // a superpage spans all colors
+    static const unsigned int ASIDS = Traits<MMU>::ASIDS;
+    static const unsigned long RAM_BASE = Memory_Map::RAM_BASE;
+    static const unsigned long RAM_TOP  = Memory_Map::RAM_TOP;
+    static const unsigned long MIO_BASE = Memory_Map::MIO_BASE;
+    static const unsigned long MIO_TOP  = Memory_Map::MIO_TOP;
+    static const unsigned long APP_LOW  = Memory_Map::APP_LOW;
+    static const unsigned long APP_HIGH = Memory_Map::APP_HIGH;
+    static const unsigned long PHY_MEM  = Memory_Map::PHY_MEM;
+
+    // Root (level 2) table
+    static const unsigned long ATTACHER_SHIFT = DIRECTORY_SHIFT + 9;
+    static const unsigned int AT_ENTRIES = 1 << 9;
+    static const unsigned int LEVELS = 3;
+
+    // SATP
+    enum : unsigned long {
+        SV39            = 8UL << 60,
+        ASID_SHIFT      = 44,
+        ASID_MASK       = 0xffffUL << ASID_SHIFT,
+        PPN_MASK        = (1UL << ASID_SHIFT) - 1
+    };
+
+    // PTEs keep the PPN at bit 10
+    static const unsigned long PPN_SHIFT = 10;
+    static const unsigned long PPN_BITS = 44;
+
+public:
+    // Page_Table and Page_Directory entries
+    typedef unsigned long PT_Entry;
+    typedef unsigned long PD_Entry;
+
+    // Address Space Identifier
+    typedef unsigned int ASID;
+
+    // Page Flags
+    class Page_Flags
+    {
+    public:
+        enum {
+            V    = 1 << 0, // Valid (0=invalid, 1=valid)
+            R    = 1 << 1, // Readable
+            W    = 1 << 2, // Writable
+            X    = 1 << 3, // Executable (R = W = X = 0 => pointer to the next level)
+            U    = 1 << 4, // Access Control (0=supervisor, 1=user)
+            G    = 1 << 5, // Global Mapping (0=ASID-tagged, 1=all address spaces)
+            A    = 1 << 6, // Accessed (set by EPOS, since some implementations trap on A=0)
+            D    = 1 << 7, // Dirty (set by EPOS, since some implementations trap on D=0)
+            CT   = 1 << 8, // RSW (0=non-contiguous, 1=contiguous)
+            IO   = 1 << 9, // RSW (0=memory, 1=I/O)
+            APP  = (V | R | W | X | U | A | D),
+            APPC = (V | R | X | U | A),
+            APPD = (V | R | W | U | A | D),
+            SYS  = (V | R | W | X | A | D),
+            KRN  = (SYS | G),
+            MIO  = (V | R | W | G | A | D | IO),
+            DMA  = (SYS | CT),
+            PD   = V,
+            MASK = (1 << PPN_SHIFT) - 1
+        };
+
+    public:
+        Page_Flags() {}
+        Page_Flags(unsigned long f) : _flags(f) {}
+        Page_Flags(Flags f) : _flags(V | A |
+                                     ((f & Flags::RD)  ? R : 0) |
+                                     ((f & Flags::RW)  ? (R | W | D) : 0) |
+                                     ((f & Flags::EX)  ? (R | X) : 0) |
+                                     ((f & Flags::USR) ? U  : 0) |
+                                     ((f & Flags::CT)  ? CT : 0) |
+                                     ((f & Flags::IO)  ? IO : 0)) {}
+
+        operator unsigned long() const { return _flags; }
+
+        friend OStream & operator<<(OStream & os, const Page_Flags & f) { os << hex << f._flags; return os; }
+
+    private:
+        unsigned long _flags;
+    };
+
+    // Page Table
+    class Page_Table
+    {
+    public:
+        Page_Table() {}
+
+        PT_Entry & operator[](unsigned int i) { return _entry[i]; }
+        Page_Table & log() { return *static_cast<Page_Table *>(phy2log(this)); }
+
+        void map(int from, int to, Page_Flags flags, Color color) {
+            Phy_Addr addr = alloc(to - from, color);
+            if(addr)
+                remap(addr, from, to, flags);
+            else
+                for( ; from < to; from++)
+                    log()[from] = phy2pte(alloc(1, color), flags);
+        }
+
+        void map_contiguous(int from, int to, Page_Flags flags, Color color) {
+            remap(alloc(to - from, color), from, to, flags);
+        }
+
+        void remap(Phy_Addr addr, int from, int to, Page_Flags flags) {
+            addr = align_page(addr);
+            for( ; from < to; from++) {
+                log()[from] = phy2pte(addr, flags);
+                addr += sizeof(Page);
+            }
+        }
+
+        void unmap(int from, int to) {
+            for( ; from < to; from++) {
+                free(pte2phy(log()[from]));
+                log()[from] = 0;
+            }
+        }
+
+        friend OStream & operator<<(OStream & os, Page_Table & pt) {
+            os << "{\n";
+            for(unsigned int i = 0; i < PT_ENTRIES; i++)
+                if(pt[i])
+                    os << "[" << i << "] \t" << pte2phy(pt[i]) << " " << hex << pte2flg(pt[i]) << dec << "\n";
+            os << "}";
+            return os;
+        }
+
+    private:
+        PT_Entry _entry[PT_ENTRIES]; // the Phy_Addr in each entry passed through phy2pte()
+    };
+
+    // Page Directory (Sv39's root table)
+    typedef Page_Table Page_Directory;
+
+    // Chunk (for Segment)
+    class Chunk
+    {
+    public:
+        Chunk() {}
+
+        Chunk(unsigned int bytes, Flags flags, Color color = WHITE)
+        : _from(0), _to(pages(bytes)), _pts(page_tables(_to - _from)), _level(0), _flags(Page_Flags(flags)), _color(color), _pt(0) {
+            for(unsigned int level = LEVELS - 1; !_pt && level; level--)
+                if(large(_to, level))
+                    map_large(alloc_aligned(_to, level_pages(level), color), level);
+            if(!_pt) {
+                _pt = calloc(_pts, WHITE);
+                if(_flags & Page_Flags::CT)
+                    _pt->map_contiguous(_from, _to, _flags, color);
+                else
+                    _pt->map(_from, _to, _flags, color);
+            }
+        }
+
+        Chunk(Phy_Addr phy_addr, unsigned int bytes, Flags flags)
+        : _from(0), _to(pages(bytes)), _pts(page_tables(_to - _from)), _level(0), _flags(Page_Flags(flags)), _color(WHITE), _pt(0) {
+            for(unsigned int level = LEVELS - 1; !_pt && level; level--)
+                if(large(_to, level) && !(phy_addr & (level_pages(level) * sizeof(Page) - 1)))
+                    map_large(phy_addr, level);
+            if(!_pt) {
+                _pt = calloc(_pts, WHITE);
+                _pt->remap(phy_addr, _from, _to, _flags);
+            }
+        }
+
+        Chunk(Phy_Addr pt, unsigned int from, unsigned int to, Flags flags)
+        : _from(from), _to(to), _pts(page_tables(_to - _from)), _level(0), _flags(flags), _color(WHITE), _pt(pt) {}
+
+        ~Chunk() {
+            if(!(_flags & Page_Flags::IO)) {
+                if(_flags & Page_Flags::CT)
+                    free(pte2phy(_pt->log()[_from]), _to - _from);
+                else
+                    for( ; _from < _to; _from++)
+                        free(pte2phy(_pt->log()[_from]));
+            }
+            free(_pt, _level ? 1 : _pts);
+        }
+
+        unsigned int pts() const { return _pts; }
+        unsigned int level() const { return _level; }
+        Page_Flags flags() const { return _flags; }
+        Color color() const { return _color; }
+        Page_Table * pt() const { return _pt; }
+        unsigned int size() const { return (_to - _from) * sizeof(Page); }
+
+        Phy_Addr phy_address() const {
+            return (_flags & Page_Flags::CT) ? pte2phy(_pt->log()[_from]) : Phy_Addr(false);
+        }
+
+        int resize(unsigned int amount) {
+            if(_flags & Page_Flags::CT)
+                return 0;
+
+            unsigned int pgs = pages(amount);
+
+            unsigned int free_pgs = _pts * PT_ENTRIES - _to;
+            if(free_pgs < pgs) { // resize _pt
+                unsigned int pts = _pts + page_tables(pgs - free_pgs);
+                Page_Table * pt = calloc(pts, WHITE);
+                memcpy(phy2log(pt), phy2log(_pt), _pts * sizeof(Page));
+                free(_pt, _pts);
+                _pt = pt;
+                _pts = pts;
+            }
+
+            _pt->map(_to, _to + pgs, _flags, _color);
+            _to += pgs;
+
+            return pgs * sizeof(Page);
+        }
+
+    private:
+        // Level 1 and 2 leaves (2 MB and 1 GB pages) are kept in a single frame pointed by _pt and copied into the directory at attach()
+        // Such chunks are contiguous, so, like other CT chunks, they can't grow (resize() returns 0). Segments that must
+        // grow should not be sized at multiples of 2 MB (or superpages should be disabled in Traits<MMU>)
+        static bool large(unsigned long pages, unsigned int level) {
+            return superpages && pages && !(pages % level_pages(level)) && (pages / level_pages(level) <= PT_ENTRIES);
+        }
+
+        void map_large(Phy_Addr phy, unsigned int level) {
+            if(!phy)
+                return;
+            _level = level;
+            _flags = _flags | Page_Flags::CT;
+            _pt = calloc(1, WHITE);
+            for(unsigned long i = 0; i < _to / level_pages(level); i++)
+                _pt->log()[i] = phy2pte(phy + i * level_pages(level) * sizeof(Page), _flags);
+        }
+
+    private:
+        unsigned int _from;
+        unsigned int _to;
+        unsigned int _pts;
+        unsigned int _level;
+        Page_Flags _flags;
+        Color _color;
+        Page_Table * _pt; // this is a physical address
+    };
+
+    // Directory (for Address_Space)
+    class Directory
+    {
+    public:
+        Directory() : _pd(calloc(1, WHITE)), _asid(asid_alloc()), _free(true) {
+            // Share the kernel's global mappings (the root entries that are leaves in the master directory)
+            for(unsigned int i = 0; i < AT_ENTRIES; i++)
+                if(is_leaf(_master->log()[i]))
+                    _pd->log()[i] = _master->log()[i];
+        }
+
+        Directory(Page_Directory * pd) : _pd(pd), _asid((pd == current()) ? Sv39_MMU::asid() : 0), _free(false) {}
+
+        ~Directory() {
+            if(_free) {
+                for(unsigned int i = 0; i < AT_ENTRIES; i++)
+                    if(_pd->log()[i] && !is_leaf(_pd->log()[i]))
+                        free(pde2phy(_pd->log()[i]));
+                free(_pd);
+                asid_free(_asid);
+            }
+        }
+
+        Phy_Addr pd() const { return _pd; }
+        ASID asid() const { return _asid; }
+
+        void activate() const { Sv39_MMU::pd(_pd, _asid); }
+
+        Log_Addr attach(const Chunk & chunk, unsigned long from = directory(APP_LOW)) {
+            for(unsigned long i = from; (i + chunk.pts()) <= directory(APP_HIGH) + 1; i++)
+                if(attach(i, chunk))
+                    return i << DIRECTORY_SHIFT;
+            return Log_Addr(false);
+        }
+
+        Log_Addr attach(const Chunk & chunk, Log_Addr addr) {
+            unsigned long from = directory(addr);
+            if((from + chunk.pts()) > PD_ENTRIES)
+                return Log_Addr(false);
+            if(attach(from, chunk))
+                return from << DIRECTORY_SHIFT;
+            return Log_Addr(false);
+        }
+
+        void detach(const Chunk & chunk) {
+            if(chunk.level() == 2) {
+                for(unsigned long i = 0; i < AT_ENTRIES; i++)
+                    if(_pd->log()[i] == chunk.pt()->log()[0]) {
+                        detach(i * PT_ENTRIES, chunk);
+                        return;
+                    }
+            } else
+                for(unsigned long i = 0; i < PD_ENTRIES; i += (pde(i) ? 1 : PT_ENTRIES)) {
+                    PD_Entry * e = pde(i);
+                    if(e && holds(*e, chunk)) {
+                        detach(i, chunk);
+                        return;
+                    }
+                }
+            db<MMU>(WRN) << "MMU::Directory::detach(pt=" << chunk.pt() << ") failed!" << endl;
+        }
+
+        void detach(const Chunk & chunk, Log_Addr addr) {
+            unsigned long from = directory(addr);
+            PD_Entry * e = (chunk.level() == 2) ? &_pd->log()[attacher(addr)] : pde(from);
+            if(!e || ((chunk.level() == 2) ? (*e != chunk.pt()->log()[0]) : !holds(*e, chunk))) {
+                db<MMU>(WRN) << "MMU::Directory::detach(pt=" << chunk.pt() << ",addr=" << addr << ") failed!" << endl;
+                return;
+            }
+            detach(from, chunk);
+        }
+
+        Phy_Addr physical(Log_Addr addr) { return Sv39_MMU::physical(addr, _pd); }
+
+    private:
+        // Level 1 entry for a given directory index, or null if the level 1 table covering it does not exist
+        PD_Entry * pde(unsigned long i) const {
+            PD_Entry root = _pd->log()[i / PT_ENTRIES];
+            if(!(root & Page_Flags::V) || is_leaf(root))
+                return 0;
+            Page_Table * l1 = pde2phy(root);
+            return &l1->log()[i % PT_ENTRIES];
+        }
+
+        // Whether a level 1 entry is the first one of chunk (i.e. points to its first page table or is its first 2 MB page)
+        static bool holds(PD_Entry e, const Chunk & chunk) {
+            return chunk.level() ? (e == chunk.pt()->log()[0]) : (!is_leaf(e) && (pde2phy(e) == chunk.pt()));
+        }
+
+        bool attach(unsigned long from, const Chunk & chunk) {
+            unsigned long n = chunk.pts();
+            Page_Table & pt = chunk.pt()->log();
+
+            if(chunk.level() == 2) { // 1 GB pages go straight into the root
+                if(from % PT_ENTRIES)
+                    return false;
+                for(unsigned long i = from / PT_ENTRIES; i < (from + n) / PT_ENTRIES; i++)
+                    if(_pd->log()[i])
+                        return false;
+                for(unsigned long i = from / PT_ENTRIES; i < (from + n) / PT_ENTRIES; i++)
+                    _pd->log()[i] = pt[i - from / PT_ENTRIES];
+                return true;
+            }
+
+            for(unsigned long i = from; i < from + n; i++) {
+                PD_Entry root = _pd->log()[i / PT_ENTRIES];
+                if(is_leaf(root)) // kernel mapping
+                    return false;
+                PD_Entry * e = pde(i);
+                if(e && *e)
+                    return false;
+            }
+            for(unsigned long i = from; i < from + n; i++) {
+                if(!pde(i))
+                    _pd->log()[i / PT_ENTRIES] = phy2pde(calloc(1, WHITE));
+                *pde(i) = chunk.level() ? pt[i - from] : phy2pde(Phy_Addr(chunk.pt() + (i - from)));
+            }
+            return true;
+        }
+
+        void detach(unsigned long from, const Chunk & chunk) {
+            unsigned long n = chunk.pts();
+            if(chunk.level() == 2)
+                for(unsigned long i = from / PT_ENTRIES; i < (from + n) / PT_ENTRIES; i++)
+                    _pd->log()[i] = 0;
+            else
+                for(unsigned long i = from; i < from + n; i++)
+                    *pde(i) = 0;
+            flush_tlb(_asid);
+        }
+
+    private:
+        Page_Directory * _pd;  // this is a physical address, but operator*() returns a logical address
+        ASID _asid;
+        bool _free;
+    };
+
+    // DMA_Buffer
+    class DMA_Buffer: public Chunk
+    {
+    public:
+        DMA_Buffer(unsigned int s) : Chunk(s, Page_Flags::DMA) {
+            Directory dir(current());
+            _log_addr = dir.attach(*this);
+            db<MMU>(TRC) << "MMU::DMA_Buffer() => " << *this << endl;
+        }
+
+        DMA_Buffer(unsigned int s, Log_Addr d): Chunk(s, Page_Flags::DMA) {
+            Directory dir(current());
+            _log_addr = dir.attach(*this);
+            memcpy(_log_addr, d, s);
+            db<MMU>(TRC) << "MMU::DMA_Buffer(phy=" << *this << " <= " << d << endl;
+        }
+
+        Log_Addr log_address() const { return _log_addr; }
+
+        friend OStream & operator<<(OStream & os, const DMA_Buffer & b) {
+            os << "{phy=" << b.phy_address() << ",log=" << b.log_address() << ",size=" << b.size() << ",flags=" << b.flags() << "}";
+            return os;
+        }
+
+    private:
+        Log_Addr _log_addr;
+    };
+
+    // Class Translation performs manual logical to physical address translations for debugging purposes only
+    class Translation
+    {
+    public:
+        Translation(Log_Addr addr, bool pt = false, Page_Directory * pd = 0): _addr(addr), _show_pt(pt), _pd(pd) {}
+
+        friend OStream & operator<<(OStream & os, const Translation & t) {
+            Page_Directory * pd = t._pd ? t._pd : current();
+            PD_Entry root = pd->log()[attacher(t._addr)];
+            os << "{addr=" << static_cast<void *>(t._addr) << ",pd=" << pd << ",pd[" << attacher(t._addr) << "]=" << hex << root << dec;
+            if(is_leaf(root))
+                os << ",f=" << pte2phy(root);
+            else if(root) {
+                Page_Table * l1 = pde2phy(root);
+                PD_Entry pde = l1->log()[directory(t._addr) % PT_ENTRIES];
+                os << ",l1=" << l1 << ",l1[" << directory(t._addr) % PT_ENTRIES << "]=" << hex << pde << dec;
+                if(is_leaf(pde))
+                    os << ",f=" << pte2phy(pde);
+                else if(pde) {
+                    Page_Table * pt = pde2phy(pde);
+                    PT_Entry pte = pt->log()[page(t._addr)];
+                    os << ",pt=" << pt;
+                    if(t._show_pt)
+                        os << "=>" << pt->log();
+                    os << ",pt[" << page(t._addr) << "]=" << hex << pte << dec << ",f=" << pte2phy(pte);
+                }
+            }
+            os << ",*addr=" << hex << *static_cast<unsigned int *>(t._addr) << dec << "}";
+            return os;
+        }
+
+    private:
+        Log_Addr _addr;
+        bool _show_pt;
+        Page_Directory * _pd;
+    };
+
+public:
+    Sv39_MMU() {}
+
+    static Phy_Addr alloc(unsigned int frames = 1, Color color = WHITE) {
+        Phy_Addr phy(false);
+
+        if(frames) {
+            List::Element * e = free_list(color).search_decrementing(frames);
+            if(colorful && !e && (color == WHITE) && (frames == 1)) // a single uncolored frame can be of any color
+                for(unsigned int c = 0; !e && (c < COLORS); c++)
+                    e = _free[c].search_decrementing(frames);
+            if(e) {
+                phy = e->object() + e->size();
+                db<MMU>(TRC) << "MMU::alloc(frames=" << frames << ",color=" << color << ") => " << phy << endl;
+            } else
+                if(colorful)
+                    db<MMU>(INF) << "MMU::alloc(frames=" << frames << ",color=" << color << ") => failed!" << endl;
+                else
+                    db<MMU>(WRN) << "MMU::alloc(frames=" << frames << ",color=" << color << ") => failed!" << endl;
+        }
+
+        return phy;
+    }
+
+    // Allocates frames aligned to a multiple of "align" frames (a power of 2), giving the excess back to the free list
+    static Phy_Addr alloc_aligned(unsigned long frames, unsigned long align, Color color = WHITE) {
+        Phy_Addr phy = alloc(frames + align - 1, color);
+        if(phy) {
+            Phy_Addr aligned = (phy + (align - 1) * sizeof(Frame)) & ~(align * sizeof(Frame) - 1);
+            unsigned long head = (aligned - phy) / sizeof(Frame);
+            free(phy, head);
+            free(aligned + frames * sizeof(Frame), align - 1 - head);
+            phy = aligned;
+        }
+        return phy;
+    }
+
+    static Phy_Addr calloc(unsigned int frames = 1, Color color = WHITE) {
+        Phy_Addr phy = alloc(frames, color);
+        memset(phy2log(phy), 0, sizeof(Frame) * frames);
+        return phy;
+    }
+
+    static void free(Phy_Addr frame, int n = 1) {
+        // Clean up MMU flags in frame address
+        frame = indexes(frame);
+        Color color = colorful ? phy2color(frame) : WHITE;
+
+        db<MMU>(TRC) << "MMU::free(frame=" << frame << ",color=" << color << ",n=" << n << ")" << endl;
+
+        if(colorful && (n > 1)) { // each frame goes back to its own color
+            for(; n > 0; n--, frame += sizeof(Frame))
+                free(frame);
+            return;
+        }
+
+        if(frame && n) {
+            List::Element * e = new (phy2log(frame)) List::Element(frame, n);
+            List::Element * m1, * m2;
+            free_list(color).insert_merging(e, &m1, &m2);
+        }
+    }
+
+    static unsigned int allocable(Color color = WHITE) { return free_list(color).head() ? free_list(color).head()->size() : 0; }
+
+    static Page_Directory * volatile current() { return static_cast<Page_Directory * volatile>(pd()); }
+
+    static Phy_Addr physical(Log_Addr addr) { return physical(addr, current()); }
+
+    static PT_Entry phy2pte(Phy_Addr frame, Page_Flags flags) { return ((frame >> PAGE_SHIFT) << PPN_SHIFT) | flags; }
+    static Phy_Addr pte2phy(PT_Entry entry) { return ((entry >> PPN_SHIFT) & ((1UL << PPN_BITS) - 1)) << PAGE_SHIFT; }
+    static Page_Flags pte2flg(PT_Entry entry) { return (entry & Page_Flags::MASK); }
+    static PD_Entry phy2pde(Phy_Addr frame) { return ((frame >> PAGE_SHIFT) << PPN_SHIFT) | Page_Flags::PD; }
+    static Phy_Addr pde2phy(PD_Entry entry) { return pte2phy(entry); }
+    static Page_Flags pde2flg(PD_Entry entry) { return (entry & Page_Flags::MASK); }
+
+    static Log_Addr phy2log(Phy_Addr phy) { return Log_Addr((RAM_BASE == PHY_MEM) ? phy : (RAM_BASE > PHY_MEM) ? phy - (RAM_BASE - PHY_MEM) : phy + (PHY_MEM - RAM_BASE)); }
+    static Phy_Addr log2phy(Log_Addr log) { return Phy_Addr((RAM_BASE == PHY_MEM) ? log : (RAM_BASE > PHY_MEM) ? log + (RAM_BASE - PHY_MEM) : log - (PHY_MEM - RAM_BASE)); }
+
+    static Color phy2color(Phy_Addr phy) { return colorful ? static_cast<Color>((phy >> PAGE_SHIFT) % COLORS) : WHITE; }
+
+    static Color log2color(Log_Addr log) { return colorful ? phy2color(physical(log)) : WHITE; }
+
+    static unsigned long attacher(const Log_Addr & addr) { return (addr >> ATTACHER_SHIFT) & (AT_ENTRIES - 1); }
+
+    // Number of 4 KB pages covered by a leaf at a given level (0 => 4 KB, 1 => 2 MB, 2 => 1 GB)
+    static constexpr unsigned long level_pages(unsigned int level) { return 1UL << (9 * level); }
+
+    // Any entry with R, W or X set is a leaf, at whatever level it is found (i.e. a 1 GB or a 2 MB page above level 0)
+    static bool is_leaf(PT_Entry entry) { return entry & (Page_Flags::R | Page_Flags::W | Page_Flags::X); }
+
+private:
+    static Phy_Addr physical(Log_Addr addr, Page_Directory * pd) {
+        PD_Entry root = pd->log()[attacher(addr)];
+        if(is_leaf(root))
+            return pte2phy(root) | (addr & ((1UL << ATTACHER_SHIFT) - 1));
+        Page_Table * l1 = pde2phy(root);
+        PD_Entry pde = l1->log()[directory(addr) % PT_ENTRIES];
+        if(is_leaf(pde))
+            return pte2phy(pde) | (addr & ((1UL << DIRECTORY_SHIFT) - 1));
+        Page_Table * pt = pde2phy(pde);
+        return pte2phy(pt->log()[page(addr)]) | offset(addr);
+    }
+
+    static Phy_Addr pd() { return (CPU::satp() & PPN_MASK) << PAGE_SHIFT; }
+    static void pd(Phy_Addr pd, ASID asid = 0) {
+        CPU::satp(SV39 | (static_cast<unsigned long>(asid) << ASID_SHIFT) | (pd >> PAGE_SHIFT));
+        if(!asid) // untagged (shared) address space
+            flush_tlb();
+    }
+
+    static ASID asid() { return (CPU::satp() & ASID_MASK) >> ASID_SHIFT; }
+
+    // ASID 0 is reserved for the master directory and as a fallback when ASIDs are exhausted (at the cost of a TLB flush on every switch)
+    static ASID asid_alloc() {
+        ASID i = _asids.find_first_zero(1);
+        if(i < _asids_max) {
+            _asids.set(i);
+            return i;
+        }
+        db<MMU>(WRN) << "MMU::asid_alloc() => no more ASIDs, sharing ASID 0!" << endl;
+        return 0;
+    }
+
+    static void asid_free(ASID asid) {
+        if(asid) {
+            flush_tlb(asid);
+            _asids.reset(asid);
+        }
+    }
+
+    // Free frames of each color, followed by the uncolored (WHITE) ones
+    static List & free_list(Color color) { return _free[(colorful && (color != WHITE)) ? color % COLORS : colorful * COLORS]; }
+
+    static void flush_tlb() { CPU::flush_tlb(); }
+    static void flush_tlb(ASID asid) { if(asid) CPU::flush_tlb_asid(asid); else CPU::flush_tlb(); }
+
+    static void init();
+
+private:
+    static List _free[colorful * COLORS + 1]; // +1 for WHITE
+    static Page_Directory * _master;
+    static Bitmap<ASIDS> _asids;
+    static ASID _asids_max;
+};
+
+class MMU: public IF<Traits<System>::multitask, Sv39_MMU, No_MMU>::Result {};
 
 __END_SYS
 
@@ -14,12 +14,17 @@ template<> struct Traits<CPU>: public Traits<Build>
     static const unsigned int WORD_SIZE         = 64;
     static const unsigned int CLOCK             = 50000000;
     static const bool unaligned_memory_access   = false;
+    static const bool vector                    = false; // use RVV 1.0 in memcpy() and memset(), vector registers are not saved on context switches
 };
 
 template<> struct Traits<MMU>: public Traits<Build>
 {
     static const bool colorful = false;
-    static const unsigned int COLORS = 1;
+    static const unsigned int LLC_SIZE = 2 * 1024 * 1024; // FU540's shared L2, the last-level cache
+    static const unsigned int LLC_WAYS = 16;
+    static const unsigned int COLORS = (LLC_SIZE / LLC_WAYS / 4096 > 32) ? 32 : LLC_SIZE / LLC_WAYS / 4096; // page-sized LLC slices, up to the 32 Colors
+    static const bool superpages = true; // map suitably sized and aligned chunks with large pages
+    static const unsigned int ASIDS = 256; // Sv39 allows up to 65536, but implementations may support fewer (probed at MMU::init())
 };
 
 template<> struct Traits<FPU>: public Traits<Build>
@@ -26,6 +26,7 @@ public:
     using Engine::Interrupt_Handler;
 
     using Engine::INT_SYS_TIMER;
+    using Engine::INT_RESCHEDULER;
     using Engine::INT_USR_TIMER;
     using Engine::INT_TIMER0;
     using Engine::INT_TIMER1;
@@ -20,6 +20,7 @@ public:
     enum {
         INT_HARD_FAULT  = CPU::EXC_HARD,
         INT_SYS_TIMER   = CPU::EXC_SYSTICK,
+        INT_RESCHEDULER = UNSUPPORTED_INTERRUPT, // single-core
 
         INT_TIMER0      = EXCS + NVIC::IRQ_GPT0A,
         INT_TIMER1      = EXCS + NVIC::IRQ_GPT1A,
@@ -27,6 +27,7 @@ public:
         INT_TIMER4              = EXCS + ARM_TIMER_IRQ,
         INT_TIMER5              = EXCS + MAILBOX_TIMER_IRQ,
         INT_SYS_TIMER           = Traits<Machine>::emulated ? INT_TIMER5 : INT_TIMER1,
+        INT_RESCHEDULER         = EXCS + MAILBOX0_IRQ, // all IPIs arrive as the local mailbox 0 interrupt
         INT_USR_TIMER           = INT_TIMER3,
         INT_TSC_TIMER           = INT_TIMER4,
         INT_GPIOA               = EXCS + GPIO_INT0,
@@ -18,6 +18,7 @@ public:
     static const unsigned int INTS = EXCS + IRQS;
 
     enum {
+        INT_RESCHEDULER = EXCS + GIC::IRQ_SOFTWARE0,
         INT_SYS_TIMER   = EXCS + GIC::IRQ_PRIVATE_TIMER,
         INT_TIMER0      = EXCS + GIC::IRQ_GLOBAL_TIMER,
         INT_TIMER1      = UNSUPPORTED_INTERRUPT,
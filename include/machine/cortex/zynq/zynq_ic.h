@@ -18,6 +18,7 @@ public:
     static const unsigned int INTS = EXCS + IRQS;
 
     enum {
+        INT_RESCHEDULER = EXCS + GIC::IRQ_SOFTWARE0,
         INT_SYS_TIMER   = EXCS + GIC::IRQ_PRIVATE_TIMER,
         INT_TIMER0      = EXCS + GIC::IRQ_GLOBAL_TIMER,
         INT_TIMER1      = UNSUPPORTED_INTERRUPT,
@@ -45,7 +46,7 @@ public:
     static Interrupt_Id irq2int(Interrupt_Id i) { return i + EXCS; }
     static Interrupt_Id int2irq(Interrupt_Id i) { return i - EXCS; }
 
-    static void ipi(unsigned int cpu, Interrupt_Id i) { gic_distributor()->send_sgi(cpu, i); }
+    static void ipi(unsigned int cpu, Interrupt_Id i) { gic_distributor()->send_sgi(cpu, int2irq(i)); }
 
     static void init() {
         gic_distributor()->init();
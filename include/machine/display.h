@@ -85,6 +85,12 @@ public:
             putc(*s++);
     }
 
+    // Raw output, with no line discipline (e.g. for binary logs)
+    static void write(const char * s, unsigned int size) {
+        for(unsigned int i = 0; i < size; i++)
+            put(s[i]);
+    }
+
     static void geometry(int * lines, int * columns) {
         *lines = LINES;
         *columns = COLUMNS;
@@ -141,6 +141,8 @@ public:
         return true;
     }
 
+    // The i8259A can't interrupt other CPUs, and the PC's IC isn't switched to the APIC on multicores (whose IPIs would
+    // arrive unmasked and never be acknowledged by this engine), so IPIs aren't supported on the PC
     static void ipi(int dest, int interrupt) {}
 };
 
@@ -479,6 +481,7 @@ public:
         INT_FIRST_HARD  = Engine::INT_FIRST_HARD,
         INT_SYS_TIMER   = Engine::INT_TIMER,
         INT_KEYBOARD    = Engine::INT_KEYBOARD,
+        INT_RESCHEDULER = Engine::INT_IPI,
         INT_LAST_HARD   = Engine::INT_LAST_HARD,
         INT_PMU,
         LAST_INT
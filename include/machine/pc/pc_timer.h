@@ -308,11 +308,16 @@ public:
     Scheduler_Timer(Microsecond quantum, const Handler & handler): Timer(SCHEDULER, 1000000 / quantum, handler) {}
 };
 
-// Timer used by Alarm
+// Timer used by Alarm (without one-shot events, so Alarm's high-resolution waits sleep in ticks)
 class Alarm_Timer: public Timer
 {
 public:
-    Alarm_Timer(const Handler & handler): Timer(ALARM, FREQUENCY, handler) {}
+    static const bool events = false;
+
+public:
+    Alarm_Timer(const Handler & handler, const Handler & event = 0): Timer(ALARM, FREQUENCY, handler) {}
+
+    void event(const CPU::Reg64 & t) {}
 };
 
 
@@ -76,6 +76,53 @@ public:
     }
 };
 
+// Platform-Level Interrupt Controller (PLIC)
+// Multiplexes the interrupts of devices (sources) into the external interrupt of each hart context (M or S mode of a
+// hart). A context only sees the sources it enables whose priority is above its threshold. A source is claimed by a
+// context before being handled and completed after that, and it's not signaled again in between.
+class PLIC
+{
+private:
+    typedef CPU::Reg32 Reg32;
+
+public:
+    static const unsigned int IRQS = Traits<IC>::PLIC_IRQS;
+
+    // Registers offsets from PLIC_BASE
+    enum {                                  // Description
+        PRIORITY                = 0x000000, // Priority of each source (32 bits per source, 0 => never interrupts)
+        PENDING                 = 0x001000, // Pending sources (1 bit per source)
+        ENABLE                  = 0x002000, // Sources enabled for each context (1 bit per source)
+        THRESHOLD               = 0x200000, // Priority threshold of each context
+        CLAIM                   = 0x200004, // Claim (read) and complete (write) of each context
+        ENABLE_CONTEXT_OFFSET   = 0x80,
+        CONTEXT_OFFSET          = 0x1000
+    };
+
+public:
+    static void priority(unsigned int irq, unsigned int p) { reg(PRIORITY + irq * sizeof(Reg32)) = p; }
+    static unsigned int priority(unsigned int irq) { return reg(PRIORITY + irq * sizeof(Reg32)); }
+
+    static void threshold(unsigned int t, unsigned int hart = CPU::mhartid()) { reg(THRESHOLD + context(hart) * CONTEXT_OFFSET) = t; }
+
+    static bool pending(unsigned int irq) { return reg(PENDING + irq / 32 * sizeof(Reg32)) & (1 << (irq % 32)); }
+
+    static void enable(unsigned int irq, unsigned int hart = CPU::mhartid()) { enables(irq, hart) = enables(irq, hart) | (1 << (irq % 32)); }
+    static void disable(unsigned int irq, unsigned int hart = CPU::mhartid()) { enables(irq, hart) = enables(irq, hart) & ~(1 << (irq % 32)); }
+
+    // The highest-priority pending source (0 if none), which won't be signaled again until completed
+    static unsigned int claim() { return reg(CLAIM + context(CPU::mhartid()) * CONTEXT_OFFSET); }
+    static void complete(unsigned int irq) { reg(CLAIM + context(CPU::mhartid()) * CONTEXT_OFFSET) = irq; }
+
+    // Machine-mode context of a hart (contexts of harts with S mode come in M and S pairs)
+    static unsigned int context(unsigned int hart) { return (Traits<IC>::PLIC_MONITOR_HART && hart) ? hart * 2 - 1 : hart * 2; }
+
+private:
+    static volatile Reg32 & enables(unsigned int irq, unsigned int hart) { return reg(ENABLE + context(hart) * ENABLE_CONTEXT_OFFSET + irq / 32 * sizeof(Reg32)); }
+
+    static volatile Reg32 & reg(unsigned int o) { return reinterpret_cast<volatile Reg32 *>(Memory_Map::PLIC_BASE)[o / sizeof(Reg32)]; }
+};
+
 class IC: private IC_Common, private CLINT
 {
     friend class Setup;
@@ -86,14 +133,22 @@ private:
 
 public:
     static const unsigned int EXCS = CPU::EXCEPTIONS;
-    static const unsigned int IRQS = CLINT::IRQS;
+    static const unsigned int IRQS = CLINT::IRQS + PLIC::IRQS;
     static const unsigned int INTS = EXCS + IRQS;
 
     using IC_Common::Interrupt_Id;
     using IC_Common::Interrupt_Handler;
+    using IC_Common::UNSUPPORTED_INTERRUPT;
 
+    // PLIC sources come after CLINT's interrupts
     enum {
-        INT_SYS_TIMER = EXCS + IRQ_MAC_TIMER
+        INT_RESCHEDULER = EXCS + IRQ_MAC_SOFT,  // IPIs are machine software interrupts
+        INT_SYS_TIMER   = EXCS + IRQ_MAC_TIMER,
+        INT_EXTERNAL    = EXCS + IRQ_MAC_EXT,   // dispatched as INT_PLIC + the source claimed from the PLIC
+        INT_PLIC        = EXCS + CLINT::IRQS,
+        INT_UART0       = Traits<IC>::IRQ_UART0 ? INT_PLIC + Traits<IC>::IRQ_UART0 : UNSUPPORTED_INTERRUPT,
+        INT_UART1       = Traits<IC>::IRQ_UART1 ? INT_PLIC + Traits<IC>::IRQ_UART1 : UNSUPPORTED_INTERRUPT,
+        INT_NIC0        = Traits<IC>::IRQ_NIC0 ? INT_PLIC + Traits<IC>::IRQ_NIC0 : UNSUPPORTED_INTERRUPT
     };
 
 public:
@@ -115,11 +170,16 @@ public:
         CPU::mie(CPU::MSI | CPU::MTI | CPU::MEI);
     }
 
+    // PLIC sources are enabled for the running hart only
     static void enable(Interrupt_Id i) {
         db<IC>(TRC) << "IC::enable(int=" << i << ")" << endl;
         assert(i < INTS);
+        if(i > INT_PLIC) {
+            if(!PLIC::priority(i - INT_PLIC))
+                PLIC::priority(i - INT_PLIC, 1);
+            PLIC::enable(i - INT_PLIC);
+        }
         enable();
-        // TODO: this should handle individual INTs and also be done at PLIC
     }
 
     static void disable() {
@@ -130,8 +190,17 @@ public:
     static void disable(Interrupt_Id i) {
         db<IC>(TRC) << "IC::disable(int=" << i << ")" << endl;
         assert(i < INTS);
-        disable();
-        // TODO: this should handle individual INTs and also be done at PLIC
+        if(i > INT_PLIC)
+            PLIC::disable(i - INT_PLIC);
+        else
+            disable();
+    }
+
+    // Sources with higher priorities are claimed first (priorities range from 1 to 7 on SiFive PLICs)
+    static void priority(Interrupt_Id i, unsigned int p) {
+        db<IC>(TRC) << "IC::priority(int=" << i << ",p=" << p << ")" << endl;
+        assert((i > INT_PLIC) && (i < INTS));
+        PLIC::priority(i - INT_PLIC, p);
     }
 
     static Interrupt_Id int_id() {
@@ -146,6 +215,14 @@ public:
     static int irq2int(int i) { return i + EXCS; }
     static int int2irq(int i) { return i - EXCS; }
 
+    // IPIs are raised through the MSIP of the target hart (CPUs are numbered from the hart running this code) and
+    // cleared by dispatch()
+    static void ipi(unsigned int cpu, Interrupt_Id i) {
+        db<IC>(TRC) << "IC::ipi(cpu=" << cpu << ",int=" << i << ")" << endl;
+        assert(i == INT_RESCHEDULER);
+        reg(MSIP + (CPU::mhartid() - CPU::id() + cpu) * MSIP_CORE_OFFSET) = 1;
+    }
+
 private:
     static void dispatch();
 
@@ -8,6 +8,7 @@
 #include <machine/timer.h>
 #include <system/memory_map.h>
 #include <utility/convert.h>
+#include <utility/per_cpu.h>
 
 __BEGIN_SYS
 
@@ -21,7 +22,7 @@ class Timer: private Timer_Common, private CLINT
 protected:
     typedef IC_Common::Interrupt_Id Interrupt_Id;
 
-    static const unsigned int CHANNELS = 2;
+    static const unsigned int CHANNELS = 4;
     static const unsigned int FREQUENCY = Traits<Timer>::FREQUENCY;
 
 public:
@@ -31,70 +32,137 @@ public:
     // Channels
     enum {
         SCHEDULER,
-        ALARM
+        ALARM,
+        USER,
+        EVENT   // Alarm's high-resolution wakeups (see Alarm_Timer)
     };
 
     static const Hertz CLOCK = Traits<Timer>::CLOCK;
 
 protected:
+    // Each channel has its own absolute deadline (in CLINT ticks) and MTIMECMP is set to the earliest of them, so the
+    // quantum isn't quantized to the alarm tick and restart() really moves the preemption point. A one-shot channel
+    // without a frequency waits for a deadline().
     Timer(unsigned int channel, const Hertz & frequency, const Handler & handler, bool retrigger = true)
-    : _channel(channel), _initial(FREQUENCY / frequency), _retrigger(retrigger), _handler(handler) {
-        db<Timer>(TRC) << "Timer(f=" << frequency << ",h=" << reinterpret_cast<void*>(handler) << ",ch=" << channel << ") => {count=" << _initial << "}" << endl;
+    : _channel(channel), _cpu(Per_CPU<Channels>::cpu()), _hart(CPU::mhartid()), _period(frequency ? CLOCK / frequency : 0), _retrigger(retrigger), _handler(handler) {
+        db<Timer>(TRC) << "Timer(f=" << frequency << ",h=" << reinterpret_cast<void*>(handler) << ",ch=" << channel << ") => {period=" << _period << "}" << endl;
 
-        if(_initial && (channel < CHANNELS) && !_channels[channel])
-            _channels[channel] = this;
-        else
-            db<Timer>(WRN) << "Timer not installed!"<< endl;
+        _deadline = _period ? time() + _period : NEVER;
 
-        _current = _initial;
+        if((_period || !retrigger) && (channel < CHANNELS) && !timer(channel)) {
+            timer(channel) = this;
+            reprogram();
+        } else
+            db<Timer>(WRN) << "Timer not installed!"<< endl;
     }
 
 public:
     ~Timer() {
-        db<Timer>(TRC) << "~Timer(f=" << frequency() << ",h=" << reinterpret_cast<void*>(_handler) << ",ch=" << _channel << ") => {count=" << _initial << "}" << endl;
+        db<Timer>(TRC) << "~Timer(h=" << reinterpret_cast<void*>(_handler) << ",ch=" << _channel << ") => {period=" << _period << "}" << endl;
 
-        _channels[_channel] = 0;
+        timer(_channel, _cpu) = 0;
+        reprogram();
     }
 
-    Tick read() { return _current; }
+    // Ticks (of FREQUENCY) to the next interrupt of this channel
+    Tick read() { return remaining() * FREQUENCY / CLOCK; }
 
+    // Returns the percentage of the period that was left
     int restart() {
-        db<Timer>(TRC) << "Timer::restart() => {f=" << frequency() << ",h=" << reinterpret_cast<void *>(_handler) << ",count=" << _current << "}" << endl;
+        Time_Stamp now = time();
+        Time_Stamp left = remaining(now);
+        db<Timer>(TRC) << "Timer::restart() => {f=" << frequency() << ",h=" << reinterpret_cast<void *>(_handler) << ",left=" << left << "}" << endl;
 
-        int percentage = _current * 100 / _initial;
-        _current = _initial;
+        _deadline = now + _period;
+        reprogram();
 
-        return percentage;
+        return _period ? left * 100 / _period : 0;
     }
 
-    static void reset() { config(FREQUENCY); }
+    // Absolute deadline, in MTIME ticks (i.e. in TSC ticks)
+    void deadline(const CPU::Reg64 & t) {
+        db<Timer>(TRC) << "Timer::deadline(t=" << t << ",ch=" << _channel << ")" << endl;
+
+        _deadline = t;
+        reprogram();
+    }
+
+    static void reset() { program(); }
     static void enable() {}
     static void disable() {}
 
-    Hertz frequency() const { return (FREQUENCY / _initial); }
-    void frequency(Hertz f) { _initial = FREQUENCY / f; reset(); }
+    Hertz frequency() const { return _period ? CLOCK / _period : 0; }
+    void frequency(Hertz f) { _period = CLOCK / f; _deadline = time() + _period; reprogram(); }
 
     void handler(const Handler & handler) { _handler = handler; }
 
 private:
+    typedef CPU::Reg64 Time_Stamp;
+
+    static const Time_Stamp NEVER = ~Time_Stamp(0);
+
+    // Each hart has its own MTIMECMP, and so its own channels
+    typedef Timer * Channels[CHANNELS];
+
+    static Timer * & timer(unsigned int c, unsigned int cpu = Per_CPU<Channels>::cpu()) { return _channels[cpu][c]; }
+
     static volatile CPU::Reg32 & reg(unsigned int o) { return reinterpret_cast<volatile CPU::Reg32 *>(Memory_Map::CLINT_BASE)[o / sizeof(CPU::Reg32)]; }
+    static volatile CPU::Reg64 & reg64(unsigned int o) { return reinterpret_cast<volatile CPU::Reg64 *>(Memory_Map::CLINT_BASE)[o / sizeof(CPU::Reg64)]; }
+
+    // MTIME is 64 bits wide even on RV32, where its halves must be read consistently
+    static Time_Stamp time() {
+        if(Traits<CPU>::WORD_SIZE == 64)
+            return reg64(MTIME);
+
+        CPU::Reg32 hi, lo;
+        do {
+            hi = reg(MTIMEH);
+            lo = reg(MTIME);
+        } while(hi != reg(MTIMEH));
+        return (Time_Stamp(hi) << 32) | lo;
+    }
 
-    static void config(const Hertz & frequency) {
-        reg(MTIMECMP) = reg(MTIME) + (CLOCK / frequency);
+    // On RV32, the low half goes to all ones first, so no spurious match happens while the halves are being written
+    static void compare(const Time_Stamp & t, unsigned int hart) {
+        unsigned int o = MTIMECMP + hart * MTIMECMP_CORE_OFFSET;
+        if(Traits<CPU>::WORD_SIZE == 64)
+            reg64(o) = t;
+        else {
+            reg(o) = ~0U;
+            reg(o + 4) = t >> 32;
+            reg(o) = t;
+        }
     }
 
+    Time_Stamp remaining(const Time_Stamp & now = time()) const { return (_deadline > now) ? _deadline - now : 0; }
+
+    // Sets a hart's MTIMECMP to the earliest deadline of its channels (which also clears MIP.MTI if the deadline is ahead)
+    static void program(unsigned int cpu = Per_CPU<Channels>::cpu(), unsigned int hart = CPU::mhartid()) {
+        Time_Stamp next = NEVER;
+        for(unsigned int i = 0; i < CHANNELS; i++)
+            if(timer(i, cpu) && (timer(i, cpu)->_deadline < next))
+                next = timer(i, cpu)->_deadline;
+        compare(next, hart);
+    }
+
+    // A timer can be changed from any hart (e.g. Alarm's events, by whichever thread calls delay()), but its deadline
+    // belongs to the hart it was installed on
+    void reprogram() { program(_cpu, _hart); }
+
     static void int_handler(Interrupt_Id i);
 
     static void init();
 
 protected:
     unsigned int _channel;
-    Tick _initial;
+    unsigned int _cpu;
+    unsigned int _hart;
+    Time_Stamp _period;
+    Time_Stamp _deadline;
     bool _retrigger;
-    volatile Tick _current;
     Handler _handler;
 
-    static Timer * _channels[CHANNELS];
+    static Per_CPU<Channels> _channels;
 };
 
 // Timer used by Thread::Scheduler
@@ -104,11 +172,37 @@ public:
     Scheduler_Timer(const Microsecond & quantum, const Handler & handler): Timer(SCHEDULER, 1000000 / quantum, handler) {}
 };
 
-// Timer used by Alarm
+// Timer available for users
+class User_Timer: public Timer
+{
+public:
+    User_Timer(unsigned int channel, const Microsecond & time, const Handler & handler, bool retrigger = false)
+    : Timer(USER, time ? 1000000 / time : 0, handler, retrigger) {
+        assert(channel == USER); // Only one user timer on RISC-V
+    }
+};
+
+// Timer used by Alarm. Besides the tick, it has one-shot events at absolute time stamps of MTIME (which is TSC),
+// which Alarm uses for high-resolution wakeups. The events have a channel of their own, so USER is left to User_Timer.
 class Alarm_Timer: public Timer
 {
+private:
+    class Event_Timer: public Timer
+    {
+    public:
+        Event_Timer(const Handler & handler): Timer(EVENT, 0, handler, false) {}
+    };
+
+public:
+    static const bool events = true;
+
 public:
-    Alarm_Timer(const Handler & handler): Timer(ALARM, FREQUENCY, handler) {}
+    Alarm_Timer(const Handler & handler, const Handler & event = 0): Timer(ALARM, FREQUENCY, handler), _event(event) {}
+
+    void event(const CPU::Reg64 & t) { _event.deadline(t); }
+
+private:
+    Event_Timer _event;
 };
 
 __END_SYS
@@ -4,11 +4,14 @@
 #define __riscv_uart_h
 
 #include <architecture/cpu.h>
+#include <machine/ic.h>
 #include <machine/uart.h>
 #include <system/memory_map.h>
 
 __BEGIN_SYS
 
+class Semaphore;
+
 class SiFive_UART
 {
 private:
@@ -215,6 +218,8 @@ private:
 
 class UART: private UART_Common, private IF<(Traits<Build>::MODEL == Traits<Build>::SiFive_U) && (Traits<CPU>::WORD_SIZE != 64), NS16500A, SiFive_UART>::Result
 {
+    friend class Machine;
+
 private:
     static const unsigned int UNIT = Traits<UART>::DEF_UNIT;
     static const unsigned int BAUD_RATE = Traits<UART>::DEF_BAUD_RATE;
@@ -222,7 +227,31 @@ private:
     static const unsigned int PARITY = Traits<UART>::DEF_PARITY;
     static const unsigned int STOP_BITS = Traits<UART>::DEF_STOP_BITS;
 
+    static const bool interrupt_driven = Traits<UART>::interrupt_driven;
+    static const unsigned int TX_BUFFER_SIZE = Traits<UART>::TX_BUFFER_SIZE;
+    static const unsigned int RX_BUFFER_SIZE = Traits<UART>::RX_BUFFER_SIZE;
+
     typedef IF<(Traits<Build>::MODEL == Traits<Build>::SiFive_U) && (Traits<CPU>::WORD_SIZE != 64), NS16500A, SiFive_UART>::Result Engine;
+    typedef IC_Common::Interrupt_Id Interrupt_Id;
+
+    // Character ring (the indices run free and are masked on access, so SIZE must be a power of two)
+    template<unsigned int SIZE>
+    class Ring
+    {
+    public:
+        Ring(): _head(0), _tail(0) {}
+
+        bool empty() const { return _head == _tail; }
+        bool full() const { return _tail - _head == SIZE; }
+
+        void put(char c) { _data[_tail++ & (SIZE - 1)] = c; }
+        char get() { return _data[_head++ & (SIZE - 1)]; }
+
+    private:
+        volatile unsigned int _head;
+        volatile unsigned int _tail;
+        char _data[SIZE];
+    };
 
 public:
     using UART_Common::NONE;
@@ -235,8 +264,8 @@ public:
 
     using Engine::config;
 
-    char get() { while(!rxd_ok()); return rxd(); }
-    void put(char c) { while(!txd_ok()); txd(c); }
+    char get() { return buffered() ? get_buffered() : get_polled(); }
+    void put(char c) { if(buffered()) put_buffered(c); else put_polled(c); }
 
     int read(char * data, unsigned int max_size) {
         for(unsigned int i = 0; i < max_size; i++)
@@ -249,14 +278,60 @@ public:
         return 0;
     }
 
-    bool ready_to_get() { return rxd_ok(); }
-    bool ready_to_put() { return txd_ok(); }
+    bool ready_to_get() { return buffered() ? !_rx.empty() : rxd_ok(); }
+    bool ready_to_put() { return buffered() ? !_tx.full() : txd_ok(); }
 
     using Engine::int_enable;
     using Engine::int_disable;
-    using Engine::flush;
+
+    void flush() {
+        if(buffered())
+            drain();
+        Engine::flush();
+    }
+
+    // Characters received while the RX ring was full (and thus lost)
+    unsigned int overruns() { return _overruns; }
 
     void power(const Power_Mode & mode);
+
+private:
+    char get_polled() { while(!rxd_ok()); return rxd(); }
+    void put_polled(char c) { while(!txd_ok()); txd(c); }
+
+    // The rings are only used after init(), which runs once the system heap is up
+    static bool buffered() { return interrupt_driven && _rx_data; }
+
+    char get_buffered();
+    void put_buffered(char c);
+    void drain();
+
+    // The rings are shared with the interrupt handler (and with other CPUs)
+    static bool lock() {
+        bool enabled = CPU::int_enabled();
+        CPU::int_disable();
+        if(Traits<Build>::CPUS > 1)
+            while(CPU::tsl(_lock));
+        return enabled;
+    }
+    static void unlock(bool enabled) {
+        if(Traits<Build>::CPUS > 1)
+            _lock = 0;
+        if(enabled)
+            CPU::int_enable();
+    }
+
+    static void int_handler(Interrupt_Id i);
+
+    static void init();
+
+private:
+    static UART * _device; // the one the interrupt handler drives
+    static Ring<TX_BUFFER_SIZE> _tx;
+    static Ring<RX_BUFFER_SIZE> _rx;
+    static Semaphore * _rx_data; // counts the characters in _rx
+    static volatile unsigned int _overruns;
+    static volatile int _lock;
 };
 
 __END_SYS
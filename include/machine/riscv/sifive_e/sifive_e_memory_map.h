@@ -26,7 +26,7 @@ public:
         BIOS_BASE       = 0x00001000,   // SiFive-E BIOS ROM
         CLINT_BASE      = 0x02000000,   // SiFive CLINT
         TIMER_BASE      = 0x02004000,   // CLINT Timer
-        PLIIC_CPU_BASE  = 0x0c000000,   // SiFive PLIC
+        PLIC_BASE       = 0x0c000000,   // SiFive PLIC
         AON_BASE        = 0x10000000,   // SiFive-E Always-On (AON) Domain (real-time stuff)
         PRCI_BASE       = 0x10008000,   // SiFive-E Power, Reset, Clock, Interrupt
         GPIO_BASE       = 0x10012000,   // SiFive-E GPIO
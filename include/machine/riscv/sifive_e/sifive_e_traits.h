@@ -53,6 +53,13 @@ public:
 template <> struct Traits<IC>: public Traits<Machine_Common>
 {
     static const bool debugged = hysterically_debugged;
+
+    // PLIC (as in the FE310)
+    static const bool PLIC_MONITOR_HART = false;
+    static const unsigned int PLIC_IRQS = 64; // sources, rounded up to a multiple of 32 (source 0 means none)
+    static const unsigned int IRQ_UART0 = 3;
+    static const unsigned int IRQ_UART1 = 4;
+    static const unsigned int IRQ_NIC0 = 0; // 0 => not present
 };
 
 template <> struct Traits<Timer>: public Traits<Machine_Common>
@@ -79,6 +86,12 @@ template <> struct Traits<UART>: public Traits<Machine_Common>
     static const unsigned int DEF_DATA_BITS = 8;
     static const unsigned int DEF_PARITY = 0; // none
     static const unsigned int DEF_STOP_BITS = 1;
+
+    // Interrupt-driven operation (TX and RX through rings of the sizes below, which must be powers of two, and readers
+    // sleeping until data arrives) instead of polling
+    static const bool interrupt_driven = false;
+    static const unsigned int TX_BUFFER_SIZE = 256;
+    static const unsigned int RX_BUFFER_SIZE = 64;
 };
 
 template<> struct Traits<Serial_Display>: public Traits<Machine_Common>
@@ -31,6 +31,8 @@ public:
     static const unsigned int IMAGE             = 0x80100000;                           // RAM_BASE + 1 MB (will be part of the free memory at INIT, defines the maximum image size; if larger than 3 MB then adjust at SETUP)
 
     // Logical Memory
+    // The kernel runs in machine mode, where satp doesn't translate, so logical addresses are physical ones even with
+    // Sv39 page tables (which only take effect for supervisor and user modes), and the application lies in RAM
     static const unsigned int APP_LOW           = library ? RAM_BASE : 0x80400000;      // 2 GB + 4 MB
     static const unsigned int APP_HIGH          = 0xff7fffff;                           // SYS - 1
 
@@ -38,7 +40,7 @@ public:
     static const unsigned int APP_DATA          = APP_CODE + 4 * 1024 * 1024;
 
     static const unsigned int INIT              = library ? NOT_USED :0x80080000;       // RAM_BASE + 512 KB (will be part of the free memory at INIT)
-    static const unsigned int PHY_MEM           = 0x20000000;                           // 512 MB (max 1536 MB of RAM)
+    static const unsigned int PHY_MEM           = RAM_BASE;                             // 2 GB (RAM is identity-mapped)
     static const unsigned int IO                = 0x00000000;                           // 0 (max 512 MB of IO = MIO_TOP - MIO_BASE)
     static const unsigned int SYS               = 0xff800000;                           // 4 GB - 8 MB
 
@@ -51,6 +53,13 @@ public:
 template <> struct Traits<IC>: public Traits<Machine_Common>
 {
     static const bool debugged = hysterically_debugged;
+
+    // PLIC (as in the FU540 for RV64, or in QEMU's Virt, which an RV32 SiFive-U is emulated on)
+    static const bool PLIC_MONITOR_HART = (Traits<CPU>::WORD_SIZE == 64); // hart 0 is an M-mode only monitor core (E51), with a single context
+    static const unsigned int PLIC_IRQS = 64; // sources, rounded up to a multiple of 32 (source 0 means none)
+    static const unsigned int IRQ_UART0 = PLIC_MONITOR_HART ? 4 : 10;
+    static const unsigned int IRQ_UART1 = PLIC_MONITOR_HART ? 5 : 0; // 0 => not present
+    static const unsigned int IRQ_NIC0 = PLIC_MONITOR_HART ? 53 : 0;
 };
 
 template <> struct Traits<Timer>: public Traits<Machine_Common>
@@ -77,6 +86,12 @@ template <> struct Traits<UART>: public Traits<Machine_Common>
     static const unsigned int DEF_DATA_BITS = 8;
     static const unsigned int DEF_PARITY = 0; // none
     static const unsigned int DEF_STOP_BITS = 1;
+
+    // Interrupt-driven operation (TX and RX through rings of the sizes below, which must be powers of two, and readers
+    // sleeping until data arrives) instead of polling
+    static const bool interrupt_driven = false;
+    static const unsigned int TX_BUFFER_SIZE = 256;
+    static const unsigned int RX_BUFFER_SIZE = 64;
 };
 
 template<> struct Traits<Serial_Display>: public Traits<Machine_Common>
@@ -19,6 +19,7 @@ public:
     ~Address_Space();
 
     using MMU::Directory::pd;
+    using MMU::Directory::activate;
 
     Log_Addr attach(Segment * seg);
     Log_Addr attach(Segment * seg, Log_Addr addr);
@@ -40,14 +41,86 @@ public:
 
 public:
     Segment(unsigned int bytes, Flags flags = Flags::APP);
+    Segment(unsigned int bytes, const Color & color, Flags flags = Flags::APP);
     Segment(Phy_Addr phy_addr, unsigned int bytes, Flags flags);
     ~Segment();
 
     unsigned int size() const;
     Phy_Addr phy_address() const;
+    Color color() const;
     int resize(int amount);
 };
 
+
+// Region allocator: objects are carved out of chunks by bumping a pointer and are all released at once by reset() or
+// by the arena's destruction (destructors are not called). Chunks come from the system's heap, from a Segment (a single,
+// fixed chunk), or from a parent arena (nesting), in which case they live as long as the parent's allocations
+class Arena
+{
+private:
+    struct Chunk {
+        Chunk * next;
+        char * top;     // valid once the chunk is no longer the current one
+        char * end;
+    };
+
+public:
+    static const unsigned int CHUNK_SIZE = 4096;
+    static const unsigned int ALIGNMENT = sizeof(long);
+
+    // Allocation state to go back to with release(), e.g. at the end of a nested scope
+    struct Mark {
+        Chunk * chunk;
+        char * top;
+    };
+
+public:
+    Arena(unsigned int chunk_size = CHUNK_SIZE);
+    Arena(Segment * segment);
+    Arena(Arena * parent, unsigned int chunk_size = CHUNK_SIZE);
+    ~Arena();
+
+    void * alloc(unsigned int bytes) {
+        bytes = (bytes + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+        if(static_cast<unsigned long>(_end - _top) < bytes)
+            return grow(bytes);
+        void * p = _top;
+        _top += bytes;
+        return p;
+    }
+
+    Mark mark() const { Mark m = { _chunk, _top }; return m; }
+    void release(const Mark & m);
+    void reset();
+
+    unsigned int chunks() const;
+    unsigned long used() const;
+
+private:
+    void * grow(unsigned int bytes);
+    static unsigned int clamp(unsigned int chunk_size) { return (chunk_size > sizeof(Chunk) + ALIGNMENT) ? chunk_size : sizeof(Chunk) + ALIGNMENT; }
+    void drop(Chunk * chunk);
+    bool holds(Chunk * chunk) const;
+    char * base(Chunk * chunk) const { return reinterpret_cast<char *>(chunk + 1); }
+
+private:
+    Arena * _parent;
+    Segment * _segment;
+    unsigned int _chunk_size;
+    Chunk * _chunk;     // current (i.e. latest) chunk, linked to the previous ones
+    char * _top;
+    char * _end;
+};
+
 __END_SYS
 
+// noexcept, so a failed allocation yields a null pointer instead of a construction at address 0
+inline void * operator new(size_t bytes, _SYS::Arena & arena) noexcept {
+    return arena.alloc(bytes);
+}
+
+inline void * operator new[](size_t bytes, _SYS::Arena & arena) noexcept {
+    return arena.alloc(bytes);
+}
+
 #endif
@@ -7,6 +7,7 @@
 #include <machine.h>
 #include <utility/queue.h>
 #include <utility/handler.h>
+#include <utility/per_cpu.h>
 #include <scheduler.h>
 
 extern "C" { void __exit(); }
@@ -58,12 +59,13 @@ public:
 
     // Thread Configuration
     struct Configuration {
-        Configuration(const State & s = READY, const Criterion & c = NORMAL, unsigned int ss = STACK_SIZE)
-        : state(s), criterion(c), stack_size(ss) {}
+        Configuration(const State & s = READY, const Criterion & c = NORMAL, unsigned int ss = STACK_SIZE, const Color & cl = WHITE)
+        : state(s), criterion(c), stack_size(ss), color(cl) {}
 
         State state;
         Criterion criterion;
         unsigned int stack_size;
+        Color color;    // cache partition for the stack (see System::colorful(); ignored, with a warning, if unsupported)
     };
 
 
@@ -80,6 +82,8 @@ public:
     const volatile Criterion & priority() const { return _link.rank(); }
     void priority(const Criterion & p);
 
+    const Color & color() const { return _color; }
+
     int join();
     void pass();
     void suspend();
@@ -107,7 +111,14 @@ protected:
     static void wakeup_all(Queue * q);
 
     static void reschedule();
+    static void reschedule(unsigned int cpu);
+    static void rescheduler(IC::Interrupt_Id interrupt);
     static void time_slicer(IC::Interrupt_Id interrupt);
+    static bool steal();
+
+    // The CPU a thread made ready should preempt: its own, for partitioned criteria, or else the one running the
+    // lowest-priority thread (the running CPU, unless another one runs a thread of lower priority than it)
+    static unsigned int cpu(Thread * t);
 
     static void dispatch(Thread * prev, Thread * next, bool charge = true);
 
@@ -118,6 +129,7 @@ private:
 
 protected:
     char * _stack;
+    Color _color;
     Context * volatile _context;
     volatile State _state;
     Queue * _waiting;
@@ -127,12 +139,13 @@ protected:
     static volatile unsigned int _thread_count;
     static Scheduler_Timer * _timer;
     static Scheduler<Thread> _scheduler;
+    static Per_CPU<Thread *> _running; // only for the other CPUs' sake, since running() is faster for the own
 };
 
 
 template<typename ... Tn>
 inline Thread::Thread(int (* entry)(Tn ...), Tn ... an)
-: _state(READY), _waiting(0), _joining(0), _link(this, NORMAL)
+: _color(WHITE), _state(READY), _waiting(0), _joining(0), _link(this, NORMAL)
 {
     constructor_prologue(STACK_SIZE);
     _context = CPU::init_stack(0, _stack + STACK_SIZE, &__exit, entry, an ...);
@@ -141,7 +154,7 @@ inline Thread::Thread(int (* entry)(Tn ...), Tn ... an)
 
 template<typename ... Tn>
 inline Thread::Thread(const Configuration & conf, int (* entry)(Tn ...), Tn ... an)
-: _state(conf.state), _waiting(0), _joining(0), _link(this, conf.criterion)
+: _color(conf.color), _state(conf.state), _waiting(0), _joining(0), _link(this, conf.criterion)
 {
     constructor_prologue(conf.stack_size);
     _context = CPU::init_stack(0, _stack + conf.stack_size, &__exit, entry, an ...);
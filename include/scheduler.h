@@ -71,11 +71,6 @@ public:
         Alarm * alarm_times;                    // pointer to RT_Thread private alarm (for monitoring purposes)
         unsigned int finished_jobs;             // number of finished jobs given by the number of times alarm->p() was called for this thread
         unsigned int missed_deadlines;          // number of missed deadlines given by the number of finished jobs (finished_jobs) minus the number of dispatched jobs (alarm_times->times)
-
-        // CPU Execution Time (capture ts)
-        static TSC::Time_Stamp _cpu_time[Traits<Build>::CPUS];              // accumulated CPU time in the current hyperperiod for each CPU
-        static TSC::Time_Stamp _last_dispatch_time[Traits<Build>::CPUS];    // time Stamp of last dispatch in each CPU
-        static TSC::Time_Stamp _last_activation_time;                       // global time stamp of the last heuristic activation
     };
 
 protected:
@@ -145,6 +140,89 @@ public:
     FCFS(int p = NORMAL, Tn & ... an);
 };
 
+// Work-Stealing Round-Robin (partitioned)
+// Each CPU has a queue of its own, so threads stay on the CPU they were placed on (and keep its caches warm), but a CPU
+// that runs out of threads takes a ready one from the busiest other queue (see Scheduling_Queue<T, WSRR>). A thread is
+// only taken by CPUs in its affinity mask, and not while it's cache-hot, i.e. if it left a CPU less than
+// MIGRATION_COST ago, since refilling another CPU's caches would then cost more than waiting for its own.
+class WSRR: public RR
+{
+public:
+    static const bool collecting = true;
+    static const bool migrating = true;
+    static const unsigned int QUEUES = Traits<Build>::CPUS;
+    static const unsigned int ALL = ANY >> (sizeof(unsigned int) * 8 - QUEUES); // affinity mask of all CPUs
+    static const unsigned int MIGRATION_COST = 500; // us
+
+public:
+    // Threads go to cpu, or, if ANY, to the running CPU (or the first one in their affinity mask, if it's not there)
+    WSRR(int p = NORMAL, unsigned int cpu = ANY, unsigned int affinity = ANY)
+    : RR(p), _affinity((affinity & ALL) ? (affinity & ALL) : ALL), _left(0) {
+        _queue = ((cpu != ANY) && allows(cpu)) ? cpu : allows(CPU::id()) ? CPU::id() : __builtin_ctz(_affinity);
+    }
+
+    unsigned int queue() const { return _queue; }
+    void queue(unsigned int q) { _queue = q; }
+
+    unsigned int affinity() const { return _affinity; }
+    bool allows(unsigned int cpu) const { return (cpu < QUEUES) && (_affinity & (1U << cpu)); }
+
+    // Called as the thread leaves the CPU
+    bool collect(bool end = false) { _left = TSC::time_stamp(); return true; }
+
+    bool stealable(unsigned int cpu, const TSC::Time_Stamp & now) const {
+        return (_priority != IDLE) && allows(cpu) && (now - _left >= Convert::us2count<TSC::Time_Stamp, Microsecond>(TSC::frequency(), MIGRATION_COST));
+    }
+
+    static unsigned int current_queue() { return CPU::id(); }
+
+protected:
+    unsigned int _queue;
+    unsigned int _affinity;
+    TSC::Time_Stamp _left;
+};
+
+// Work-stealing queues: one per CPU (see WSRR)
+template<typename T>
+class Scheduling_Queue<T, WSRR>: public Scheduling_Multilist<T>
+{
+private:
+    typedef Scheduling_Multilist<T> Base;
+
+public:
+    typedef typename Base::Element Element;
+
+public:
+    // Moves the first ready object the running CPU may take from the busiest other queue to the running CPU's queue
+    Element * steal() {
+        unsigned int here = WSRR::current_queue();
+        TSC::Time_Stamp now = TSC::time_stamp();
+
+        Element * victim = 0;
+        unsigned int load = 0;
+        for(unsigned int q = 0; q < WSRR::QUEUES; q++) {
+            if((q == here) || (Base::size(q) <= load))
+                continue;
+            for(typename Base::Iterator i = Base::begin(q); i != Base::end(); i++)
+                if(i->rank().stealable(here, now)) {
+                    victim = i;
+                    load = Base::size(q);
+                    break;
+                }
+        }
+
+        if(victim) {
+            Base::remove(victim);
+            WSRR c = victim->rank();
+            c.queue(here);
+            victim->rank(c);
+            Base::insert(victim);
+        }
+
+        return victim;
+    }
+};
+
 __END_SYS
 
 #endif
@@ -16,6 +16,10 @@ class Application
     friend void * ::malloc(size_t);
     friend void ::free(void *);
 
+public:
+    // The heap behind malloc() and new, e.g. for "cout << Application::heap()" (see Traits<Heaps>::monitored)
+    static const Heap & heap();
+
 private:
     static void init();
 
@@ -28,27 +32,45 @@ class System
 {
     friend class Init_System;                                                   // for _heap
     friend class Init_Application;                                              // for _heap with multiheap = false
+    friend class Application;                                                   // for _heap with multiheap = false
     friend void CPU::Context::load() const volatile;
     friend void * ::malloc(size_t);						// for _heap
     friend void ::free(void *);							// for _heap
     friend void * ::operator new(size_t, const EPOS::System_Allocator &);	// for _heap
     friend void * ::operator new[](size_t, const EPOS::System_Allocator &);	// for _heap
+    friend void * ::operator new(size_t, const EPOS::Color &);		// for heap()
+    friend void * ::operator new[](size_t, const EPOS::Color &);		// for heap()
     friend void ::operator delete(void *);					// for _heap
     friend void ::operator delete[](void *);					// for _heap
 
 public:
     static System_Info * const info() { assert(_si); return _si; }
 
+    // Whether new (color) really takes memory of that color (otherwise, it comes from the plain system's heap)
+    static bool colorful() { return colored; }
+
+private:
+    // Colored heaps need multiheap, since their blocks must be freed through the heap pointer they carry, and a kernel
+    // that translates addresses, so that the colored frames behind a segment look contiguous. Only IA32 does the latter
+    // (RISC-V runs the kernel in machine mode, where satp is ignored), so colorful is ignored on other architectures.
+    static const bool colored = Traits<MMU>::colorful && Traits<System>::multiheap && (Traits<Build>::ARCHITECTURE == Traits<Build>::IA32);
+    static const unsigned int COLORS = colored ? Traits<MMU>::COLORS : 1;
+
 private:
     static void init();
 
+    static Heap * heap(const Color & color) { return (colored && (color != WHITE)) ? _colored_heap[color % COLORS] : _heap; }
+
 private:
     static System_Info * _si;
     static char _preheap[(Traits<System>::multiheap ? sizeof(Segment) : 0) + sizeof(Heap)];
     static Segment * _heap_segment;
     static Heap * _heap;
+    static Heap * _colored_heap[COLORS];
 };
 
+inline const Heap & Application::heap() { return Traits<System>::multiheap ? *_heap : *System::_heap; }
+
 __END_SYS
 
 extern "C"
@@ -94,6 +116,15 @@ inline void * operator new[](size_t bytes, const EPOS::System_Allocator & alloca
     return _SYS::System::_heap->alloc(bytes);
 }
 
+// Allocation from the system's heap of a given cache color (the plain system's heap for WHITE or without colorful)
+inline void * operator new(size_t bytes, const EPOS::Color & color) {
+    return _SYS::System::heap(color)->alloc(bytes);
+}
+
+inline void * operator new[](size_t bytes, const EPOS::Color & color) {
+    return _SYS::System::heap(color)->alloc(bytes);
+}
+
 // Delete cannot be declared inline due to virtual destructors
 void operator delete(void * ptr);
 void operator delete[](void * ptr);
@@ -106,6 +106,7 @@ class RM;
 class DM;
 class EDF;
 class GRR;
+class WSRR;
 class Fixed_CPU;
 class CPU_Affinity;
 class GEDF;
@@ -116,6 +117,7 @@ class EA_PEDF;
 
 class Address_Space;
 class Segment;
+class Arena;
 
 class Synchronizer;
 class Mutex;
@@ -15,7 +15,7 @@ enum Color {
     COLOR_8,  COLOR_9,  COLOR_10, COLOR_11, COLOR_12, COLOR_13, COLOR_14, COLOR_15,
     COLOR_16, COLOR_17, COLOR_18, COLOR_19, COLOR_20, COLOR_21, COLOR_22, COLOR_23,
     COLOR_24, COLOR_25, COLOR_26, COLOR_27, COLOR_28, COLOR_29, COLOR_30, COLOR_31,
-    WHITE = COLOR_0
+    WHITE // no color constraint (i.e. any frame)
 };
 
 // Power Management Modes
@@ -39,18 +39,43 @@ private:
     typedef Relative_Queue<Alarm, Tick> Queue;
 
 public:
-    Alarm(const Microsecond & time, Handler * handler, unsigned int times = 1);
+    typedef TSC::Time_Stamp Time_Stamp;
+
+private:
+    typedef Ordered_List<Semaphore, Time_Stamp> Events;
+
+    static const unsigned int LATENCY = 100; // us, first guess for the wakeup latency, refined by each event interrupt
+
+public:
+    // An alarm with slack may go off up to that much later than asked, together with others, in fewer dispatches
+    Alarm(const Microsecond & time, Handler * handler, unsigned int times = 1, const Microsecond & slack = 0);
     ~Alarm();
 
     const Microsecond & period() const { return _time; }
     void period(const Microsecond & p);
 
+    Microsecond slack() const { return _slack * timer_period(); }
+    void slack(const Microsecond & s);
+
     void reset();
 
     static Hertz frequency() { return _timer->frequency(); }
 
     static void delay(const Microsecond & time);
 
+    // Number of ticks in which alarms went off (in each, all the alarms due went off together), and of ticks handled
+    // at all (i.e. timer interrupts, except where the timer catches up on late ones in a single interrupt)
+    static unsigned int dispatches() { return _dispatches; }
+    static unsigned int interrupts() { return _elapsed; }
+
+    // High-resolution waits, on absolute time stamps of the TSC. The thread sleeps until shortly before the deadline
+    // (as early as the timer interrupt latency observed so far, which never exceeds a tick) and spins the rest.
+    static Time_Stamp deadline(const Microsecond & time) { return TSC::time_stamp() + time_stamp(time); }
+    static void delay_until(const Time_Stamp & deadline);
+
+    // How late a timer interrupt may come (waits shorter than this are busy)
+    static Microsecond latency() { return _latency * 1000000 / TSC::frequency(); }
+
 private:
     unsigned int times() const { return _times; }
 
@@ -58,11 +83,17 @@ private:
 
     static Microsecond timer_period() { return 1000000 / frequency(); }
     static Tick ticks(const Microsecond & time) { return (time + timer_period() / 2) / timer_period(); }
+    static Tick slack_ticks(const Microsecond & time) { return time / timer_period(); } // never more than tolerated
+    static Time_Stamp time_stamp(const Microsecond & time) { return static_cast<Time_Stamp>(time) * TSC::frequency() / 1000000; }
+
+    static void spin(const Time_Stamp & deadline) { while(TSC::time_stamp() < deadline); }
+    static void calibrate(const Time_Stamp & measured);
 
     static void lock() { Thread::lock(); }
     static void unlock() { Thread::unlock(); }
 
     static void handler(IC::Interrupt_Id i);
+    static void event_handler(IC::Interrupt_Id i);
 
     static void init();
 
@@ -71,11 +102,15 @@ private:
     Handler * _handler;
     unsigned int _times;
     Tick _ticks;
+    Tick _slack;
     Queue::Element _link;
 
     static Alarm_Timer * _timer;
     static volatile Tick _elapsed;
     static Queue _request;
+    static volatile unsigned int _dispatches;
+    static Events _events;
+    static volatile Time_Stamp _latency;
 };
 
 
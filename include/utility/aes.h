@@ -11,32 +11,96 @@
 __BEGIN_UTIL
 
 // EPOS 128-bit Advanced Encryption Standard (AES) Software Implementation
-// Adapted from https://github.com/kokke/tiny-AES128-C
+// Rounds are computed with 32-bit T-tables (SubBytes, ShiftRows and MixColumns folded into four lookups per column), as
+// in the reference implementation by Rijmen, Bosselaers and Barreto. Table lookups depend on the data, so this engine is
+// not constant-time with respect to cache timing. On ARMv8 with the Cryptographic Extension (Traits<CPU>::crypto),
+// blocks are processed by AESE/AESMC and AESD/AESIMC instead, which are constant-time.
+// Besides the one-shot ECB/CBC interface, a key can be set once and many blocks processed per call in CTR mode
+// (see also GCM in utility/gcm.h).
 template<>
 class SWAES<16>: public AES_Common
 {
 private:
-    static const unsigned int Nb = 4; // number of columns comprising a _state
+    static const unsigned int Nb = 4; // number of columns comprising a state
     static const unsigned int Nk = 4; // number of 32 bit words in a key
-    static const int Nr = 10; // number of rounds in AES cipher
+    static const unsigned int Nr = 10; // number of rounds in AES cipher
+
+    // Round tables, computed at compile time and placed in read-only storage
+    struct Tables
+    {
+        static constexpr unsigned char xtime(unsigned char x) { return (x << 1) ^ ((x & 0x80) ? 0x1b : 0); }
+        static constexpr unsigned char multiply(unsigned char x, unsigned char y) {
+            return ((y & 1) ? x : 0) ^ ((y & 2) ? xtime(x) : 0) ^ ((y & 4) ? xtime(xtime(x)) : 0) ^ ((y & 8) ? xtime(xtime(xtime(x))) : 0);
+        }
+        static constexpr unsigned char rotl(unsigned char x, unsigned int s) { return (x << s) | (x >> (8 - s)); }
+        static constexpr unsigned int column(unsigned char a, unsigned char b, unsigned char c, unsigned char d) {
+            return (static_cast<unsigned int>(a) << 24) | (static_cast<unsigned int>(b) << 16) | (static_cast<unsigned int>(c) << 8) | d;
+        }
+        static constexpr unsigned int rotr(unsigned int x, unsigned int s) { return (x >> s) | (x << (32 - s)); }
+
+        constexpr Tables(): sbox{}, rsbox{}, te{}, td{} {
+            // S-box as the affine transform of the multiplicative inverse: p walks GF(2^8) by multiplying by 3 while q walks it dividing by 3
+            unsigned char p = 1, q = 1;
+            do {
+                p = p ^ xtime(p);
+                q ^= q << 1;
+                q ^= q << 2;
+                q ^= q << 4;
+                if(q & 0x80)
+                    q ^= 0x09;
+                sbox[p] = q ^ rotl(q, 1) ^ rotl(q, 2) ^ rotl(q, 3) ^ rotl(q, 4) ^ 0x63;
+            } while(p != 1);
+            sbox[0] = 0x63;
+
+            for(unsigned int i = 0; i < 256; i++) {
+                unsigned char s = sbox[i];
+                rsbox[s] = i;
+                te[0][i] = column(xtime(s), s, s, xtime(s) ^ s);
+            }
+            for(unsigned int i = 0; i < 256; i++) {
+                unsigned char r = rsbox[i];
+                td[0][i] = column(multiply(r, 0x0e), multiply(r, 0x09), multiply(r, 0x0d), multiply(r, 0x0b));
+            }
+            for(unsigned int t = 1; t < 4; t++)
+                for(unsigned int i = 0; i < 256; i++) {
+                    te[t][i] = rotr(te[0][i], 8 * t);
+                    td[t][i] = rotr(td[0][i], 8 * t);
+                }
+        }
 
-    typedef unsigned char State[4][4]; // array holding the intermediate results during decryption
+        unsigned char sbox[256];
+        unsigned char rsbox[256];
+        unsigned int te[4][256];
+        unsigned int td[4][256];
+    };
 
 public:
     static const unsigned int KEY_SIZE = 16;
+    static const unsigned int BLOCK_SIZE = 16;
 
 public:
-    SWAES(const Mode & m = ECB): _mode(m) {
+    SWAES(const Mode & m = ECB): _mode(m), _keyed(false) {
         assert((m == ECB) || (m == CBC));
-        for(unsigned int i = 0; i < 23; i++)
-            iv[i] = 0;
+        memset(_iv, 0, BLOCK_SIZE);
     }
 
     Mode mode() { return _mode; }
 
+    // One-shot interface: one block per call, with the key given at each call (it is only expanded again if it changes).
+    // In CBC mode, each call is a one-block message chained from the configured IV (which is all zeros)
     void encrypt(const unsigned char * data, const unsigned char * key, unsigned char * result) { crypt(data, key, result, true); }
     void decrypt(const unsigned char * data, const unsigned char * key, unsigned char * result) { crypt(data, key, result, false); }
 
+    // Keyed interface
+    void key(const unsigned char * k);
+    void encrypt(const unsigned char * in, unsigned char * out) const;
+    void decrypt(const unsigned char * in, unsigned char * out) const;
+
+    // Counter mode: encrypts or decrypts (it's the same) size bytes from in to out, which can be the same buffer.
+    // The 128-bit big-endian counter is advanced past the blocks used, so a stream can be processed in several calls
+    // as long as all but the last are multiples of BLOCK_SIZE
+    void ctr(const unsigned char * in, unsigned char * out, size_t size, unsigned char * counter) const;
+
 private:
     void mode(const Mode & m) {
         assert((m == ECB) || (m == CBC));
@@ -54,18 +118,27 @@ private:
             db<Ciphers>(INF) << "," << int(key[i]);
         db<Ciphers>(INF) << "}" << endl;
 
+        if(!_keyed || memcmp(_key, key, KEY_SIZE))
+            this->key(key);
+
         switch(_mode) {
         case CBC:
-            if(encrypt)
-                cbc_encrypt_buffer(result, data, 16, key, iv);
-            else
-                cbc_decrypt_buffer(result, data, 16, key, iv);
+            if(encrypt) {
+                unsigned char block[BLOCK_SIZE];
+                for(unsigned int i = 0; i < BLOCK_SIZE; i++)
+                    block[i] = data[i] ^ _iv[i];
+                this->encrypt(block, result);
+            } else {
+                this->decrypt(data, result);
+                for(unsigned int i = 0; i < BLOCK_SIZE; i++)
+                    result[i] ^= _iv[i];
+            }
             break;
         case ECB:
             if(encrypt)
-                ebc_encrypt(data, key, result);
+                this->encrypt(data, result);
             else
-                ebc_decrypt(data, key, result);
+                this->decrypt(data, result);
             break;
         }
 
@@ -75,48 +148,19 @@ private:
         db<Ciphers>(INF) << "}" << endl;
     }
 
-    void cbc_encrypt_buffer(unsigned char * output, const unsigned char * input, int length, const unsigned char * key, unsigned char * iv);
-    void cbc_decrypt_buffer(unsigned char * output, const unsigned char * input, int length, const unsigned char * key, unsigned char * iv);
-    void ebc_encrypt(const unsigned char * input, const unsigned char * key, unsigned char *output);
-    void ebc_decrypt(const unsigned char * input, const unsigned char * key, unsigned char *output);
-
-    void expand_key();
-    void add_round_key(int round);
-    void sub_bytes();
-    void shift_rows();
-    void mix_columns();
-    void inv_mix_columns();
-    void inv_sub_bytes();
-    void inv_shift_rows();
-
-    void cipher();
-    void inv_cipher();
-
-    void block_copy(unsigned char * output, const unsigned char * input) { memcpy(output, input, KEY_SIZE); }
-
-    unsigned char xtime(unsigned char x) { return ((x<<1) ^ (((x>>7) & 1) * 0x1b)); }
-    unsigned char multiply(unsigned char x, unsigned char y) {
-        return (((y & 1) * x) ^
-                ((y >> 1 & 1) * xtime(x)) ^
-                ((y >> 2 & 1) * xtime(xtime(x))) ^
-                ((y >> 3 & 1) * xtime(xtime(xtime(x)))) ^
-                ((y >> 4 & 1) * xtime(xtime(xtime(xtime(x))))));
-    }
-
-    void xor_with_iv(unsigned char * buf) { for(unsigned int i = 0; i < KEY_SIZE; ++i) buf[i] ^= _iv[i]; }
+    static unsigned int load(const unsigned char * b) { return Tables::column(b[0], b[1], b[2], b[3]); }
+    static void store(unsigned char * b, unsigned int w) { b[0] = w >> 24; b[1] = w >> 16; b[2] = w >> 8; b[3] = w; }
 
 private:
     Mode _mode;
-
-    State * _state;
-    unsigned char _round_key[176];
-    const unsigned char * _key;
-    unsigned char * _iv; // initial Vector used only for CBC mode
-    unsigned char iv[23];
-
-    static const unsigned char sbox[256];
-    static const unsigned char rsbox[256];
-    static const unsigned char rcon[255];
+    bool _keyed;
+    unsigned char _key[KEY_SIZE];
+    unsigned char _iv[BLOCK_SIZE]; // initialization vector, used only for CBC mode
+    unsigned int _round_key[Nb * (Nr + 1)];
+    unsigned int _inv_round_key[Nb * (Nr + 1)]; // for the equivalent inverse cipher (InvMixColumns applied to the inner round keys)
+
+    static const Tables _tables;
+    static const unsigned char rcon[Nr + 1];
 };
 
 __END_UTIL
@@ -10,14 +10,19 @@ __BEGIN_UTIL
 // This class implements a prime finite field (Fp or GF(p))
 // It basically consists of (possibly) big numbers between 0 and a prime modulo, with + - * / operators
 // Primarily meant to be used primarily by asymmetric cryptography (e.g. Diffie-Hellman)
+// Digits are as wide as the CPU's registers when the compiler offers a double-width (128-bit) type for their products,
+// so 64-bit CPUs multiply four times fewer digits. Products are reduced with Barrett's method (see barrett_reduction()).
 template<unsigned int SIZE>
 class Bignum
 {
-    template<typename Cipher> friend class Poly1305;
-
 public:
+#ifdef __SIZEOF_INT128__
+    typedef unsigned long Digit;
+    typedef unsigned __int128 Double_Digit;
+#else
     typedef unsigned int Digit;
     typedef unsigned long long Double_Digit;
+#endif
 
     static const unsigned int DIGITS = (SIZE + sizeof(Digit) - 1) / sizeof(Digit);
     static const unsigned int BITS_PER_DIGIT = sizeof(Digit) * 8;
@@ -32,7 +37,7 @@ private:
     };
     union _Barrett {
         unsigned char bytes[sizeof(Word) + sizeof(Digit)];
-        Digit data[sizeof(Word) / sizeof(Digit)];
+        Digit data[sizeof(Word) / sizeof(Digit) + 1];
     };
 
 public:
@@ -43,7 +48,7 @@ public:
         for(unsigned int i = 0, j = 0; i < DIGITS; i++) {
             _data[i] = 0;
             for(unsigned int k = 0; k < sizeof(Digit) && j < len; k++, j++)
-                _data[i] += (reinterpret_cast<const unsigned char *>(bytes)[j] << (8 * k));
+                _data[i] += Digit(reinterpret_cast<const unsigned char *>(bytes)[j]) << (8 * k);
         }
     }
 
@@ -97,9 +102,7 @@ public:
             db<Bignum>(TRC) << _mod.data[DIGITS - 1] << "]) => ";
         }
 
-        Digit mult_result[2 * DIGITS];
-        simple_mult(mult_result, _data, b._data, DIGITS);
-        barrett_reduction(_data, mult_result, DIGITS);
+        multiply(b, false);
 
         if(Traits<Bignum>::hysterically_debugged)
             db<Bignum>(TRC) << *this << endl;
@@ -113,10 +116,7 @@ public:
             db<Bignum>(TRC) << _mod.data[DIGITS - 1] << "]) => ";
         }
 
-        if(simple_add(_data, _data, b._data, DIGITS))
-            simple_sub(_data, _data, _mod.data, DIGITS);
-        if(cmp(_data, _mod.data, DIGITS) >= 0)
-            simple_sub(_data, _data, _mod.data, DIGITS);
+        add(b, false);
 
         if(Traits<Bignum>::hysterically_debugged)
             db<Bignum>(TRC) << *this << endl;
@@ -130,8 +130,7 @@ public:
             db<Bignum>(TRC) << _mod.data[DIGITS - 1] << "]) => ";
         }
 
-        if(simple_sub(_data, _data, b._data, DIGITS))
-            simple_add(_data, _data, _mod.data, DIGITS);
+        subtract(b, false);
 
         if(Traits<Bignum>::hysterically_debugged)
             db<Bignum>(TRC) << *this << endl;
@@ -193,12 +192,31 @@ public:
         int i;
         for(i = DIGITS - 1; i >= 0 && (_mod.data[i] == 0); i--)
             _data[i]=0;
-        _data[i] = Random::random() % _mod.data[i];
-        for(--i; i >= 0; i--)
-            _data[i] = Random::random();
+        Random::fill(_data, (i + 1) * sizeof(Digit));
+        _data[i] %= _mod.data[i];
     }
 
-    void invert() __attribute__((noinline)) { // _data = i, such that (_data * i) % _mod = 1
+    // Copies b if condition holds, without branching on it (for constant-time code)
+    void select(const Bignum & b, bool condition) { select(_data, b._data, condition, DIGITS); }
+
+    // _data = i, such that (_data * i) % _mod = 1
+    // The binary extended Euclidean algorithm takes a path that depends on _data. If constant_time is set, the inverse is
+    // computed instead as _data^(_mod - 2) (Fermat), whose sequence of multiplications depends only on the (public) _mod.
+    void invert(bool constant_time = false) __attribute__((noinline)) {
+        if(constant_time) {
+            Bignum base(*this), two(2);
+            Word e;
+            simple_sub(e, _mod.data, two._data, DIGITS);
+            int i = DIGITS * BITS_PER_DIGIT - 1;
+            for(; !((e[i / BITS_PER_DIGIT] >> (i % BITS_PER_DIGIT)) & 1); i--);
+            for(i--; i >= 0; i--) {
+                multiply(*this, true);
+                if((e[i / BITS_PER_DIGIT] >> (i % BITS_PER_DIGIT)) & 1)
+                    multiply(base, true);
+            }
+            return;
+        }
+
         Bignum A(1), u, v, zero(0);
         for(unsigned int i = 0; i < DIGITS; i++) {
             u._data[i] = _data[i];
@@ -238,7 +256,7 @@ public:
         unsigned int i;
         out << '[';
         for(i=0;i<DIGITS;i++) {
-            out << (unsigned int)b._data[i];
+            out << b._data[i];
             if(i < DIGITS-1)
                 out << ", ";
         }
@@ -250,7 +268,7 @@ public:
         unsigned int i;
         out << '[';
         for(i = 0; i < DIGITS; i++) {
-            out << (unsigned int)b._data[i];
+            out << b._data[i];
             if(i < DIGITS - 1)
                 out << ", ";
         }
@@ -258,7 +276,50 @@ public:
         return out;
     }
 
+protected:
+    // With constant_time set (see Constant_Time_Bignum), these make no branches that depend on the values of the operands
+    void multiply(const Bignum & b, bool constant_time) {
+        Digit mult_result[2 * DIGITS];
+        simple_mult(mult_result, _data, b._data, DIGITS);
+        barrett_reduction(_data, mult_result, constant_time);
+    }
+
+    void add(const Bignum & b, bool constant_time) {
+        if(constant_time) {
+            // The sum is reduced if it either overflowed or is still not below _mod
+            Word reduced;
+            bool carry = simple_add(_data, _data, b._data, DIGITS);
+            bool borrow = simple_sub(reduced, _data, _mod.data, DIGITS);
+            select(_data, reduced, carry | !borrow, DIGITS);
+        } else {
+            if(simple_add(_data, _data, b._data, DIGITS))
+                simple_sub(_data, _data, _mod.data, DIGITS);
+            if(cmp(_data, _mod.data, DIGITS) >= 0)
+                simple_sub(_data, _data, _mod.data, DIGITS);
+        }
+    }
+
+    void subtract(const Bignum & b, bool constant_time) {
+        if(constant_time) {
+            Word mod;
+            Digit mask = -Digit(simple_sub(_data, _data, b._data, DIGITS));
+            for(unsigned int i = 0; i < DIGITS; i++)
+                mod[i] = _mod.data[i] & mask;
+            simple_add(_data, _data, mod, DIGITS);
+        } else {
+            if(simple_sub(_data, _data, b._data, DIGITS))
+                simple_add(_data, _data, _mod.data, DIGITS);
+        }
+    }
+
 private:
+    // res = condition ? a : res, with a mask instead of a branch
+    static void select(Digit * res, const Digit * a, bool condition, unsigned int size) {
+        Digit mask = -Digit(condition);
+        for(unsigned int i = 0; i < size; i++)
+            res[i] ^= (res[i] ^ a[i]) & mask;
+    }
+
     static int cmp(const Digit * a, const Digit * b, int size) { // a == b -> 0, a > b -> 1, a < b -> -1
         for(int i = size - 1; i >= 0; i--) {
             if(a[i] > b[i]) return 1;
@@ -272,14 +333,13 @@ private:
     // -No modulo applied
     // -a, b and res are assumed to have size 'size'
     // -a, b, res are allowed to point to the same place
-    static bool simple_sub(Digit * res, const Digit * a, const Digit * b, unsigned int size) __attribute__((noinline)) {
-        Double_Digit borrow = 0;
-        Double_Digit aux = Double_Digit(1) << BITS_PER_DIGIT;
+    static bool simple_sub(Digit * res, const Digit * a, const Digit * b, unsigned int size) {
+        Digit borrow = 0;
         for(unsigned int i = 0; i < size; i++) {
-            Double_Digit anow = a[i];
-            Double_Digit bnow = Double_Digit(b[i]) + borrow;
-            borrow = (anow < bnow);
-            res[i] = borrow ? (aux - bnow) + anow : anow - bnow;
+            Digit diff = a[i] - b[i];
+            Digit next = (a[i] < b[i]) | (diff < borrow);
+            res[i] = diff - borrow;
+            borrow = next;
         }
         return borrow;
     }
@@ -289,7 +349,7 @@ private:
     // -No modulo applied
     // -a, b and res are assumed to have size 'size'
     // -a, b, res are allowed to point to the same place
-    static bool simple_add(Digit * res, const Digit * a, const Digit * b, unsigned int size) __attribute__((noinline)) {
+    static bool simple_add(Digit * res, const Digit * a, const Digit * b, unsigned int size) {
         bool carry = 0;
         for(unsigned int i = 0; i < size; i++) {
             Double_Digit tmp = Double_Digit(carry) + Double_Digit(a[i]) + Double_Digit(b[i]);
@@ -303,97 +363,81 @@ private:
     // - Does not apply module
     // - a and b are assumed to be of size 'size'
     // - res is assumed to be of size '2*size'
+    // Row by row, so each digit product takes a single double-digit multiply-accumulate with the carry kept in one digit
     static void simple_mult(Digit * res, const Digit * a, const Digit * b, unsigned int size) {
-        unsigned int i;
-        Double_Digit r0 = 0, r1 = 0, r2 = 0;
-        for(i = 0; i < size * 2 - 1; i++) {
-            for(unsigned int j = 0; (j < size) && (j <= i); j++) {
-                unsigned int k = i - j;
-                if(k < size) {
-                    Double_Digit aj = a[j];
-                    Double_Digit bk = b[k];
-                    Double_Digit prod = aj * bk;
-                    r0 += Digit(prod);
-                    r1 += (prod >> BITS_PER_DIGIT) + (r0 >> BITS_PER_DIGIT);
-                    r0 = Digit(r0);
-                    r2 += (r1 >> BITS_PER_DIGIT);
-                    r1 = Digit(r1);
-                }
-            }
-            res[i] = r0;
-            r0 = r1;
-            r1 = r2;
-            r2 = 0;
+        for(unsigned int i = 0; i < size; i++)
+            res[i] = 0;
+        for(unsigned int i = 0; i < size; i++) {
+            Digit carry = 0;
+            for(unsigned int j = 0; j < size; j++)
+                carry = mac(res[i + j], a[i], b[j], carry);
+            res[i + size] = carry;
         }
-        res[i] = r0;
     }
 
-    // res = a % _mod
-    // - Intended to be used after a multiplication
-    // - res is assumed to be of size 'size'
-    // - a is assumed to be of size '2*size'
-    void barrett_reduction(Digit * res, const Digit * a, unsigned int size) {
-        Digit q[size + 1];
+    // r = Digit(r + a * b + carry), returning the upper digit (which can't overflow: (B-1)^2 + 2(B-1) < B^2)
+    static Digit mac(Digit & r, Digit a, Digit b, Digit carry) {
+        Double_Digit t = Double_Digit(a) * b + r + carry;
+        r = Digit(t);
+        return t >> BITS_PER_DIGIT;
+    }
 
-        // q = floor( ( floor( a/base^(size-1) ) * barrett_u ) / base^(size+1))
-        Double_Digit r0 = 0, r1 = 0, r2 = 0;
-        unsigned int i;
-        for(i = 0; i < (2 * (size + 1)) - 1; i++) {
-            for(unsigned int j = 0; (j < size + 1) && (j <= i); j++) {
-                unsigned int k = i - j;
-                if(k < size + 1) {
-                    // shifting left (little endian) size-1 places
-                    // a is assumed to have size size*2
-                    Double_Digit aj = a[j + (size - 1)];
-                    Double_Digit bk = _barrett_u.data[k];
-                    Double_Digit prod = aj * bk;
-                    r0 += Digit(prod);
-                    r1 += (prod >> BITS_PER_DIGIT) + (r0 >> BITS_PER_DIGIT);
-                    r0 = Digit(r0);
-                    r2 += r1 >> BITS_PER_DIGIT;
-                    r1 = Digit(r1);
-                }
-            }
-            // shifting left (little endian) size+1 places
-            if(i >= size + 1)
-                q[i - (size + 1)] = r0;
-            r0 = r1;
-            r1 = r2;
-            r2 = 0;
+    // res = a % _mod (Barrett reduction, HAC 14.42)
+    // - Intended to be used after a multiplication
+    // - res is assumed to be of size DIGITS
+    // - a is assumed to be of size 2 * DIGITS
+    // q estimates a / _mod from the upper digits of a and _barrett_u = floor(base^(2 * DIGITS) / _mod), so that r = a - q * _mod
+    // only needs its lower DIGITS + 1 digits. Products of digits that fall below position DIGITS - 1 are not computed for q
+    // (HAC 14.44): they could carry at most 1 into it, so q falls short by at most 3 and r takes at most 3 subtractions of _mod
+    // (in constant time, all 3 are done, and each kept or discarded with a mask).
+    // Sizes are compile-time constants, so the loops can be unrolled and no variable-length arrays are needed.
+    void barrett_reduction(Digit * res, const Digit * a, bool constant_time) {
+        // q = floor( ( floor( a/base^(DIGITS-1) ) * barrett_u ) / base^(DIGITS+1))
+        Digit t[2 * (DIGITS + 1)];
+        for(unsigned int i = 0; i < 2 * (DIGITS + 1); i++)
+            t[i] = 0;
+        for(unsigned int i = 0; i < DIGITS + 1; i++) {
+            Digit carry = 0;
+            for(unsigned int j = (i < DIGITS - 1) ? DIGITS - 1 - i : 0; j < DIGITS + 1; j++)
+                carry = mac(t[i + j], a[i + (DIGITS - 1)], _barrett_u.data[j], carry);
+            t[i + DIGITS + 1] = carry;
         }
-        q[i - (size + 1)] = r0;
-
-        Digit r[size + 1];
-        // r = (q * _mod) % base^(size+1)
-        r0 = 0, r1 = 0, r2 = 0;
-        for(i = 0; i < size + 1; i++) {
-            for(unsigned int j = 0; j <= i; j++) {
-                unsigned int k = i - j;
-                Double_Digit aj = q[j];
-                Double_Digit bk = (k == size ? 0 : _mod.data[k]);
-                Double_Digit prod = aj * bk;
-                r0 += Digit(prod);
-                r1 += (prod >> BITS_PER_DIGIT) + (r0 >> BITS_PER_DIGIT);
-                r0 = Digit(r0);
-                r2 += r1 >> BITS_PER_DIGIT;
-                r1 = Digit(r1);
-            }
-            r[i] = r0;
-            r0 = r1;
-            r1 = r2;
-            r2 = 0;
+        const Digit * q = &t[DIGITS + 1];
+
+        // r = (q * _mod) % base^(DIGITS+1)
+        Digit r[DIGITS + 1];
+        for(unsigned int i = 0; i < DIGITS + 1; i++)
+            r[i] = 0;
+        for(unsigned int i = 0; i < DIGITS + 1; i++) {
+            Digit carry = 0;
+            for(unsigned int j = 0; (j < DIGITS) && (i + j < DIGITS + 1); j++)
+                carry = mac(r[i + j], q[i], _mod.data[j], carry);
+            if(i == 0)
+                r[DIGITS] = carry;
         }
-
-        // r = ((a % base^(size+1)) - r) % base^(size+1)
-        simple_sub(r, a, r, size+1);
+        // r = ((a % base^(DIGITS+1)) - r) % base^(DIGITS+1)
+        simple_sub(r, a, r, DIGITS + 1);
 
         // _data = r % _mod
-        while((r[size] > 0) || (cmp(r, _mod.data, size) >= 0)) {
-            if(simple_sub(r, r, _mod.data, size))
-                r[size]--;
+        if(!constant_time) {
+            while((r[DIGITS] > 0) || (cmp(r, _mod.data, DIGITS) >= 0)) {
+                if(simple_sub(r, r, _mod.data, DIGITS))
+                    r[DIGITS]--;
+            }
+        } else for(unsigned int n = 0; n < 3; n++) {
+            Digit t[DIGITS + 1];
+            Digit borrow = 0;
+            for(unsigned int i = 0; i < DIGITS + 1; i++) {
+                Digit m = (i < DIGITS) ? _mod.data[i] : 0;
+                Digit diff = r[i] - m;
+                Digit next = (r[i] < m) | (diff < borrow);
+                t[i] = diff - borrow;
+                borrow = next;
+            }
+            select(r, t, !borrow, DIGITS + 1);
         }
 
-        for(unsigned int i = 0; i < size; i++)
+        for(unsigned int i = 0; i < DIGITS; i++)
             res[i] = r[i];
     }
 
@@ -404,6 +448,24 @@ private:
     static const _Barrett _barrett_u;
 };
 
+// Bignum whose arithmetic takes the same time whatever the values of the operands, at the cost of always doing the
+// conditional subtractions of the modular reductions (for constant-time cryptography, e.g. Diffie_Hellman<Cipher, true>)
+template<unsigned int SIZE>
+class Constant_Time_Bignum: public Bignum<SIZE>
+{
+public:
+    Constant_Time_Bignum(unsigned int n = 0): Bignum<SIZE>(n) {}
+    Constant_Time_Bignum(const void * bytes, unsigned int len): Bignum<SIZE>(bytes, len) {}
+
+    using Bignum<SIZE>::operator=;
+
+    void operator*=(const Bignum<SIZE> & b) __attribute__((noinline)) { this->multiply(b, true); }
+    void operator+=(const Bignum<SIZE> & b) __attribute__((noinline)) { this->add(b, true); }
+    void operator-=(const Bignum<SIZE> & b) __attribute__((noinline)) { this->subtract(b, true); }
+
+    void invert() { Bignum<SIZE>::invert(true); }
+};
+
 __END_UTIL
 
 #endif
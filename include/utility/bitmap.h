@@ -7,55 +7,171 @@
 
 __BEGIN_UTIL
 
+// Bitmap of BITS bits, stored in machine words, with searches (first set, first zero, last set), ranges and counts.
+// Searches go a word at a time, using the compiler's bit-scan builtins (which become CLZ/CTZ/BSF/RBIT instructions where
+// the ISA has them, or a few table lookups in libgcc where it doesn't). Maps larger than SUMMARY_THRESHOLD words also
+// keep two summaries with a bit per word, telling whether the word has any bit set and any bit clear, so a search
+// takes two bit scans (up to BPW * BPW bits) instead of a walk over all the words. Searches return BITS if there is
+// no such bit.
 template<unsigned int BITS>
 class Bitmap
 {
 private:
-    static const unsigned int BPI = sizeof(int) * 8;
-    static const unsigned int SIZE = (BITS + BPI - 1) / BPI;
-    static const unsigned int mask = BPI - 1;
+    typedef unsigned long Word;
+
+    static const unsigned int BPW = sizeof(Word) * 8;
+    static const unsigned int WORDS = (BITS + BPW - 1) / BPW;
+    static const unsigned int mask = BPW - 1;
+
+    static const unsigned int SUMMARY_THRESHOLD = 4;
+    static const bool summarized = WORDS > SUMMARY_THRESHOLD;
+    static const unsigned int SUMMARY_WORDS = summarized ? (WORDS + BPW - 1) / BPW : 1;
 
 public:
-    Bitmap() { memset(&_map, 0, SIZE * sizeof(int)); }
+    Bitmap() { clear(); }
+
+    bool test(unsigned int index) const { return (index < BITS) && (_map[index / BPW] & bit(index)); }
 
+    // Return whether the bit changed
     bool set(unsigned int index) {
-        if((index < BITS) && !(_map[index / BPI] & (1 << (index & mask)))) {
-            _map[index / BPI] |= (1 << (index & mask));
+        if((index < BITS) && !(_map[index / BPW] & bit(index))) {
+            _map[index / BPW] |= bit(index);
+            summarize(index / BPW);
             return true;
         }
         return false;
     }
 
     bool reset(unsigned int index) {
-        if((index < BITS) && (_map[index / BPI] & (1 << (index & mask)))) {
-            _map[index / BPI] &= ~(1 << (index & mask));
+        if((index < BITS) && (_map[index / BPW] & bit(index))) {
+            _map[index / BPW] &= ~bit(index);
+            summarize(index / BPW);
             return true;
         }
         return false;
     }
 
-    bool full(unsigned int upto) const {
-        unsigned int i;
-        for(i = 0; i < upto / BPI; i++)
-            if(_map[i] != ~0U)
-                return false;
-        if((upto & mask) && ((_map[i] | ~((1 << (upto & mask)) - 1)) != ~0U))
-            return false;
-        return true;
+    // Ranges (clipped to BITS)
+    void set(unsigned int first, unsigned int count) { range(first, count, true); }
+    void reset(unsigned int first, unsigned int count) { range(first, count, false); }
+
+    void clear() {
+        memset(_map, 0, sizeof(_map));
+        if(summarized) {
+            memset(_used, 0, sizeof(_used));
+            memset(_free, 0xff, sizeof(_free));
+        }
+    }
+
+    // Population count
+    unsigned int count() const {
+        unsigned int n = 0;
+        for(unsigned int i = 0; i < WORDS; i++)
+            n += __builtin_popcountl(_map[i]);
+        return n;
+    }
+
+    unsigned int find_first_set(unsigned int from = 0) const { return find(from, false); }
+    unsigned int find_first_zero(unsigned int from = 0) const { return find(from, true); }
+
+    unsigned int find_last_set() const {
+        int w = WORDS - 1;
+        if(summarized) {
+            int s = SUMMARY_WORDS - 1;
+            for(; (s >= 0) && !_used[s]; s--);
+            if(s < 0)
+                return BITS;
+            w = s * BPW + msb(_used[s]);
+        } else
+            for(; (w >= 0) && !_map[w]; w--);
+        return (w < 0) ? BITS : w * BPW + msb(_map[w]);
+    }
+
+    bool full(unsigned int upto = BITS) const { return find_first_zero() >= upto; }
+    bool empty(unsigned int upto = BITS) const { return find_first_set() >= upto; }
+
+private:
+    static Word bit(unsigned int index) { return Word(1) << (index & mask); }
+    static unsigned int lsb(Word w) { return __builtin_ctzl(w); }
+    static unsigned int msb(Word w) { return BPW - 1 - __builtin_clzl(w); }
+
+    void summarize(unsigned int w) {
+        if(summarized) {
+            if(_map[w])
+                _used[w / BPW] |= bit(w);
+            else
+                _used[w / BPW] &= ~bit(w);
+            if(~_map[w])
+                _free[w / BPW] |= bit(w);
+            else
+                _free[w / BPW] &= ~bit(w);
+        }
+    }
+
+    // First bit set (or clear, if zero) from index on
+    unsigned int find(unsigned int from, bool zero) const {
+        if(from >= BITS)
+            return BITS;
+
+        Word invert = zero ? ~Word(0) : 0;
+        unsigned int w = from / BPW;
+        Word m = (_map[w] ^ invert) & (~Word(0) << (from & mask));
+
+        if(!m) {
+            if(summarized) {
+                if(++w >= WORDS)
+                    return BITS;
+                const Word * summary = zero ? _free : _used;
+                unsigned int s = w / BPW;
+                Word sm = summary[s] & (~Word(0) << (w & mask));
+                while(!sm) {
+                    if(++s >= SUMMARY_WORDS)
+                        return BITS;
+                    sm = summary[s];
+                }
+                w = s * BPW + lsb(sm);
+                if(w >= WORDS)
+                    return BITS;
+                m = _map[w] ^ invert;
+            } else {
+                do {
+                    if(++w >= WORDS)
+                        return BITS;
+                    m = _map[w] ^ invert;
+                } while(!m);
+            }
+        }
+
+        unsigned int index = w * BPW + lsb(m);
+        return (index < BITS) ? index : BITS; // the unused bits at the end of the last word are all clear
     }
 
-    bool empty(unsigned int upto = BITS) const {
-        unsigned int i;
-        for(i = 0; i < upto / BPI; i++)
-            if(_map[i])
-                return false;
-        if((upto & mask) && (_map[i] & ((1 << (upto & mask)) - 1)))
-            return false;
-        return true;
+    void range(unsigned int first, unsigned int count, bool value) {
+        if(first >= BITS)
+            return;
+        if(count > BITS - first)
+            count = BITS - first;
+
+        while(count) {
+            unsigned int w = first / BPW;
+            unsigned int n = BPW - (first & mask);
+            if(n > count)
+                n = count;
+            Word bits = ((n == BPW) ? ~Word(0) : ((Word(1) << n) - 1)) << (first & mask);
+            if(value)
+                _map[w] |= bits;
+            else
+                _map[w] &= ~bits;
+            summarize(w);
+            first += n;
+            count -= n;
+        }
     }
 
 private:
-     unsigned int _map[SIZE];
+    Word _map[WORDS];
+    Word _used[SUMMARY_WORDS]; // word i has some bit set
+    Word _free[SUMMARY_WORDS]; // word i has some bit clear
 };
 
 __END_UTIL
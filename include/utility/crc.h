@@ -7,26 +7,72 @@
 
 __BEGIN_UTIL
 
+// Table-driven Cyclic Redundancy Checks
+// CRC-16 is CCITT (poly 0x1021, MSB first, init 0, as XMODEM), CRC-32 is IEEE 802.3 and CRC-32C is Castagnoli (iSCSI, ext4).
+// All of them take and return final values, so data can be checksummed in pieces: crc32(b, m, crc32(a, n)) == crc32(a|b, n + m)
 class CRC
 {
 public:
-    static unsigned short crc16(char * ptr, int size) {
-        unsigned short crc = 0;
-
-        while(--size >= 0) {
-            crc ^= (unsigned short)(*ptr++) << 8;
-            int i = 8;
-            do{
-        	if(crc & 0x8000)
-        	    crc = (crc << 1) ^ 0x1021;
-        	else
-        	    crc = crc << 1;
-            } while(--i);
+    enum Method {
+        BITWISE   = 0,  // no tables, 8 shifts per byte
+        BYTEWISE  = 1,  // one 256-entry table lookup per byte
+        SLICING_4 = 4,  // four lookups per 32-bit word
+        SLICING_8 = 8,  // eight lookups per 64 bits
+        HARDWARE,       // CRC instructions, if the CPU has them (otherwise SLICING_8)
+        BEST = HARDWARE
+    };
+
+#ifdef __armv8__
+    static const bool hardware = true; // ARMv8 CRC32 extension (mandatory from v8.1, present in the Cortex-A53)
+#else
+    static const bool hardware = false;
+#endif
+
+private:
+    static const unsigned short CRC16_POLY = 0x1021;
+    static const unsigned int CRC32_POLY = 0xedb88320;  // 0x04c11db7 reflected
+    static const unsigned int CRC32C_POLY = 0x82f63b78; // 0x1edc6f41 reflected
+
+    // Slice s gives the CRC of a byte followed by s zero bytes. Tables are computed at compile time and kept in read-only storage
+    template<typename T, T POLY, bool REFLECTED>
+    struct Table
+    {
+        constexpr Table(): t{} {
+            for(unsigned int i = 0; i < 256; i++) {
+                T c = REFLECTED ? i : i << (sizeof(T) * 8 - 8);
+                for(unsigned int k = 0; k < 8; k++)
+                    if(REFLECTED)
+                        c = (c & 1) ? (c >> 1) ^ POLY : c >> 1;
+                    else
+                        c = (c >> (sizeof(T) * 8 - 1)) ? (c << 1) ^ POLY : c << 1;
+                t[0][i] = c;
+            }
+            for(unsigned int s = 1; s < 8; s++)
+                for(unsigned int i = 0; i < 256; i++)
+                    t[s][i] = REFLECTED ? (t[s - 1][i] >> 8) ^ t[0][t[s - 1][i] & 0xff] : (t[s - 1][i] << 8) ^ t[0][t[s - 1][i] >> (sizeof(T) * 8 - 8)];
         }
 
-        return crc;
-    }
+        T t[8][256];
+    };
+
+    typedef Table<unsigned short, CRC16_POLY, false> CRC16_Table;
+    typedef Table<unsigned int, CRC32_POLY, true> CRC32_Table;
+    typedef Table<unsigned int, CRC32C_POLY, true> CRC32C_Table;
+
+public:
+    static unsigned short crc16(const void * data, size_t size, unsigned short crc = 0, Method method = BEST);
+    static unsigned int crc32(const void * data, size_t size, unsigned int crc = 0, Method method = BEST);
+    static unsigned int crc32c(const void * data, size_t size, unsigned int crc = 0, Method method = BEST);
+
+private:
+    static unsigned int reflected(const unsigned int (& t)[8][256], unsigned int poly, const unsigned char * data, size_t size, unsigned int crc, Method method);
+    static unsigned int hw_crc32(const unsigned char * data, size_t size, unsigned int crc);
+    static unsigned int hw_crc32c(const unsigned char * data, size_t size, unsigned int crc);
 
+private:
+    static const CRC16_Table _crc16;
+    static const CRC32_Table _crc32;
+    static const CRC32C_Table _crc32c;
 };
 
 __END_UTIL
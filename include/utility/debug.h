@@ -18,6 +18,197 @@ public:
     Debug & operator<<(T p) { kerr << p; return *this; }
 };
 
+// Deferred-format debugging (Traits<Debug>::binary): db<>() lines are recorded instead of formatted. String literals
+// go as the lower 32 bits of their addresses (their contents are in the ELF image), numbers as varints and the rest as
+// raw bytes, so a line costs a few stores and takes a fraction of the size of its text. tools/eposlog formats the
+// records on the host as OStream would. A record is SYNC, the size of the payload and the payload (a sequence of
+// tokens), so text printed by other means can be mixed with records. Objects that can only print themselves to an
+// OStream end the current record and go out as text. Whatever is left in a record when the statement ends (i.e. when
+// the temporary db<>() returned is destroyed) is committed then, so lines without endl aren't lost.
+class Binary_Debug
+{
+public:
+    enum : unsigned char {
+        SYNC            = 0xeb,
+
+        // Tokens
+        LITERAL         = 'S',  // lower 32 bits of the address (4 bytes, little endian)
+        STRING          = 's',  // size (1 byte) and characters
+        CHAR            = 'c',  // 1 byte
+        SIGNED          = 'i',  // zigzag varint
+        UNSIGNED        = 'u',  // varint
+        POINTER         = 'p',  // varint (printed with sizeof(void *) * 2 digits)
+        FLOAT           = 'f',  // IEEE 754 single precision (4 bytes, little endian)
+        HEX             = 'h',
+        DEC             = 'd',
+        OCT             = 'o',
+        BIN             = 'b',
+        ENDL            = 'n'
+    };
+
+private:
+    static const unsigned int HEADER = 2;
+    static const unsigned int SIZE = 96;
+    static const unsigned int MAX_TOKEN = 11; // tag and a 64-bit varint
+
+    template<bool> struct Enum {};
+
+    template<typename T> struct Plain { typedef T Type; };
+    template<typename T> struct Plain<T &> { typedef T Type; };
+    template<typename T> struct Plain<T &&> { typedef T Type; };
+
+    template<typename T>
+    struct Item { static Binary_Debug & put(Binary_Debug & d, const T & o) { return d.object(o, Enum<__is_enum(T)>()); } };
+    template<unsigned int N>
+    struct Item<const char[N]> { static Binary_Debug & put(Binary_Debug & d, const char * s) { return d.literal(s); } };
+    template<unsigned int N>
+    struct Item<char[N]> { static Binary_Debug & put(Binary_Debug & d, const char * s) { return d.string(s); } };
+    template<typename T>
+    struct Item<T *> { static Binary_Debug & put(Binary_Debug & d, T * p) { return d.pointer(p); } };
+    template<typename T>
+    struct Item<T * const> { static Binary_Debug & put(Binary_Debug & d, T * p) { return d.pointer(p); } };
+
+public:
+    Binary_Debug(): _size(HEADER), _error(false) {}
+    ~Binary_Debug() { flush(); }
+
+    Binary_Debug & operator<<(const OStream::Begl & begl) { return *this; }
+
+    Binary_Debug & operator<<(const OStream::Endl & endl) {
+        reserve(1);
+        _record[_size++] = ENDL;
+        flush();
+        if(_error) {
+            _error = false;
+            _print_trailler(true);
+        }
+        return *this;
+    }
+
+    Binary_Debug & operator<<(const OStream::Err & err) { _error = true; return *this; }
+
+    Binary_Debug & operator<<(const OStream::Hex & hex) { return tag(HEX); }
+    Binary_Debug & operator<<(const OStream::Dec & dec) { return tag(DEC); }
+    Binary_Debug & operator<<(const OStream::Oct & oct) { return tag(OCT); }
+    Binary_Debug & operator<<(const OStream::Bin & bin) { return tag(BIN); }
+
+    Binary_Debug & operator<<(char c) {
+        tag(CHAR);
+        _record[_size++] = c;
+        return *this;
+    }
+
+    // Integers are taken the way OStream takes them (e.g. long as int)
+    Binary_Debug & operator<<(bool b) { return number(b); }
+    Binary_Debug & operator<<(short s) { return number(s); }
+    Binary_Debug & operator<<(int i) { return number(i); }
+    Binary_Debug & operator<<(long l) { return number(static_cast<int>(l)); }
+    Binary_Debug & operator<<(long long l) { return number(l); }
+    Binary_Debug & operator<<(unsigned char c) { return unumber(c); }
+    Binary_Debug & operator<<(unsigned short s) { return unumber(s); }
+    Binary_Debug & operator<<(unsigned int u) { return unumber(u); }
+    Binary_Debug & operator<<(unsigned long l) { return unumber(static_cast<unsigned int>(l)); }
+    Binary_Debug & operator<<(unsigned long long l) { return unumber(l); }
+
+    Binary_Debug & operator<<(float f) {
+        union { float f; unsigned int u; } v;
+        v.f = f;
+        tag(FLOAT);
+        for(unsigned int i = 0; i < 4; i++, v.u >>= 8)
+            _record[_size++] = v.u;
+        return *this;
+    }
+    Binary_Debug & operator<<(double d) { return operator<<(static_cast<float>(d)); }
+
+    // Anything else is told apart by its type: string literals are arrays of const chars (which other strings hardly
+    // ever are), pointers to chars are strings, other pointers are printed as addresses, enums as numbers, and objects
+    // that know how to print themselves go out as text
+    template<typename T>
+    Binary_Debug & operator<<(T && o) { return Item<typename Plain<T>::Type>::put(*this, o); }
+
+private:
+    Binary_Debug & tag(unsigned char t) {
+        reserve(MAX_TOKEN);
+        _record[_size++] = t;
+        return *this;
+    }
+
+    void varint(unsigned long long v) {
+        for(; v >= 0x80; v >>= 7)
+            _record[_size++] = v | 0x80;
+        _record[_size++] = v;
+    }
+
+    Binary_Debug & literal(const char * s) {
+        unsigned int a = reinterpret_cast<unsigned long>(s);
+        tag(LITERAL);
+        for(unsigned int i = 0; i < 4; i++, a >>= 8)
+            _record[_size++] = a;
+        return *this;
+    }
+
+    Binary_Debug & number(long long v) {
+        tag(SIGNED);
+        varint((static_cast<unsigned long long>(v) << 1) ^ static_cast<unsigned long long>(v >> 63));
+        return *this;
+    }
+
+    Binary_Debug & unumber(unsigned long long v) {
+        tag(UNSIGNED);
+        varint(v);
+        return *this;
+    }
+
+    Binary_Debug & string(const char * s) {
+        while(*s) {
+            tag(STRING);
+            unsigned char & n = _record[_size++];
+            for(n = 0; *s && (_size < SIZE); s++, n++)
+                _record[_size++] = *s;
+        }
+        return *this;
+    }
+
+    Binary_Debug & pointer(const char * s) { return string(s); }
+    Binary_Debug & pointer(char * s) { return string(s); }
+    template<typename T>
+    Binary_Debug & pointer(T * p) {
+        tag(POINTER);
+        varint(reinterpret_cast<unsigned long>(p));
+        return *this;
+    }
+
+    template<typename T>
+    Binary_Debug & object(const T & e, Enum<true>) { return number(static_cast<long long>(e)); }
+    template<typename T>
+    Binary_Debug & object(T o, Enum<false>) { // a copy, as with Debug, so non-const conversions work
+        flush();
+        kerr << o;
+        return *this;
+    }
+
+    void reserve(unsigned int n) {
+        if(_size + n > SIZE)
+            flush();
+    }
+
+    void flush() {
+        if(_size > HEADER) {
+            _record[0] = SYNC;
+            _record[1] = _size - HEADER;
+            commit(_record, _size);
+            _size = HEADER;
+        }
+    }
+
+    static void commit(const unsigned char * record, unsigned int size);
+
+private:
+    unsigned int _size;
+    unsigned char _record[SIZE];
+    bool _error; // this is an ERR line, so the error trailer follows its endl
+};
+
 class Null_Debug
 {
 public:
@@ -29,7 +220,7 @@ public:
 };
 
 template<bool debugged>
-class Select_Debug: public Debug {};
+class Select_Debug: public IF<Traits<Debug>::binary, Binary_Debug, Debug>::Result {};
 template<>
 class Select_Debug<false>: public Null_Debug {};
 
@@ -42,9 +233,10 @@ db(Debug_Error l)
 {
     extern OStream::Err error;
 
-    Select_Debug<(Traits<T>::debugged && Traits<Debug>::error)>() << begl;
-    Select_Debug<(Traits<T>::debugged && Traits<Debug>::error)>() << error;
-    return Select_Debug<(Traits<T>::debugged && Traits<Debug>::error)>();
+    // The error mark goes with the returned object, since the line is only over when it is
+    Select_Debug<(Traits<T>::debugged && Traits<Debug>::error)> d;
+    d << begl << error;
+    return d;
 }
 
 template<typename T1, typename T2>
@@ -53,9 +245,9 @@ db(Debug_Error l)
 {
     extern OStream::Err error;
 
-    Select_Debug<((Traits<T1>::debugged || Traits<T2>::debugged) && Traits<Debug>::error)>() << begl;
-    Select_Debug<((Traits<T1>::debugged || Traits<T2>::debugged) && Traits<Debug>::error)>() << error;
-    return Select_Debug<((Traits<T1>::debugged || Traits<T2>::debugged) && Traits<Debug>::error)>();
+    Select_Debug<((Traits<T1>::debugged || Traits<T2>::debugged) && Traits<Debug>::error)> d;
+    d << begl << error;
+    return d;
 }
 
 // Warning
@@ -8,7 +8,12 @@
 
 __BEGIN_UTIL
 
-template<typename Cipher>
+// ECDH over secp128r1 (y^2 = x^3 - 3x + b mod 2^128 - 2^97 - 1), with points in Jacobian coordinates.
+// Key pairs for the default base point are generated with a fixed-base comb over a precomputed table (COMB_TEETH
+// doublings fewer per scalar bit), other scalar multiplications (i.e. shared keys) use a width-WINDOW NAF.
+// With constant_time set, every scalar bit (comb column or window) takes the same doublings, additions and full-table
+// lookups whatever its value, results are picked with masks instead of branches, and coordinates are Constant_Time_Bignums.
+template<typename Cipher, bool constant_time = false>
 class Diffie_Hellman
 {
 public:
@@ -16,10 +21,21 @@ public:
     static const unsigned int PUBLIC_KEY_SIZE = 2 * SECRET_SIZE;
 
 private:
-    typedef _UTIL::Bignum<SECRET_SIZE> Bignum;
+    typedef typename IF<constant_time, Constant_Time_Bignum<SECRET_SIZE>, _UTIL::Bignum<SECRET_SIZE>>::Result Bignum;
+
+    static const unsigned int COMB_TEETH = 4;
+    static const unsigned int COMB_POINTS = (1 << COMB_TEETH) - 1;
+    static const unsigned int WINDOW = 4;
 
     class Elliptic_Curve_Point
     {
+    private:
+        typedef typename Bignum::Digit Digit;
+
+        static const unsigned int BITS = Bignum::DIGITS * Bignum::BITS_PER_DIGIT;
+        static const unsigned int COMB_SPACING = BITS / COMB_TEETH;
+        static const unsigned int MULTIPLES = constant_time ? (1 << WINDOW) - 1 : 1 << (WINDOW - 2); // 1P to 15P, or 1P, 3P, 5P and 7P
+
     public:
         typedef typename Diffie_Hellman::Bignum Coordinate;
 
@@ -28,6 +44,9 @@ private:
 
         void operator*=(const Coordinate & b);
 
+        // *this = k * G, for the base point G whose comb table is given (table[i - 1] = sum of bit t of i * 2^(t * COMB_SPACING) * G)
+        void comb(const Coordinate & k, const unsigned char (* table)[2][SECRET_SIZE]);
+
         friend Debug &operator<<(Debug &out, const Elliptic_Curve_Point &a) {
             out << "{x=" << a.x << ",y=" << a.y << ",z=" << a.z << "}";
             return out;
@@ -40,6 +59,30 @@ private:
     private:
         void jacobian_double();
         void add_jacobian_affine(const Elliptic_Curve_Point &b);
+        void to_affine();
+
+        void wnaf_multiply(const Coordinate & k);
+        void window_multiply(const Coordinate & k);
+
+        // Copies b if condition holds, without branching on it
+        void select(const Elliptic_Curve_Point & b, bool condition) {
+            x.select(b.x, condition);
+            y.select(b.y, condition);
+            z.select(b.z, condition);
+        }
+
+        // Reads table[index] touching every entry, so the memory access pattern doesn't give index away
+        static Elliptic_Curve_Point lookup(const Elliptic_Curve_Point * table, unsigned int size, unsigned int index) {
+            Elliptic_Curve_Point p(table[0]);
+            for(unsigned int i = 1; i < size; i++)
+                p.select(table[i], i == index);
+            return p;
+        }
+
+        static void multiples(Elliptic_Curve_Point * table, const Elliptic_Curve_Point & p, unsigned int n);
+        static unsigned int wnaf(signed char * naf, const Coordinate & k);
+
+        static unsigned int bit(const Coordinate & k, unsigned int i) { return (k[i / Bignum::BITS_PER_DIGIT] >> (i % Bignum::BITS_PER_DIGIT)) & 1; }
 
     public:
         Coordinate x, y, z;
@@ -51,14 +94,20 @@ public:
     typedef Bignum Private_Key;
 
     Diffie_Hellman() {
-        new (&_base_point.x) Bignum(_default_base_point_x, SECRET_SIZE);
-        new (&_base_point.y) Bignum(_default_base_point_y, SECRET_SIZE);
-        _base_point.z = 1;
-        generate_keypair();
+        default_base_point();
+        _private.randomize();
+        generate_keypair(_default_comb);
     }
 
     Diffie_Hellman(const Elliptic_Curve_Point & base_point): _base_point(base_point) {
-        generate_keypair();
+        _private.randomize();
+        generate_keypair(0);
+    }
+
+    // A given private key for the default base point (e.g. for known-answer tests)
+    Diffie_Hellman(const Private_Key & private_key): _private(private_key) {
+        default_base_point();
+        generate_keypair(_default_comb);
     }
 
     Elliptic_Curve_Point public_key() { return _public; }
@@ -74,16 +123,24 @@ public:
     }
 
 private:
-    void generate_keypair() {
-        db<Diffie_Hellman>(TRC) << "Diffie_Hellman::generate_keypair()" << endl;
+    void default_base_point() {
+        new (&_base_point.x) Bignum(_default_base_point_x, SECRET_SIZE);
+        new (&_base_point.y) Bignum(_default_base_point_y, SECRET_SIZE);
+        _base_point.z = 1;
+    }
 
-        _private.randomize();
+    void generate_keypair(const unsigned char (* table)[2][SECRET_SIZE]) {
+        db<Diffie_Hellman>(TRC) << "Diffie_Hellman::generate_keypair()" << endl;
 
         db<Diffie_Hellman>(INF) << "Diffie_Hellman Private: " << _private << endl;
         db<Diffie_Hellman>(INF) << "Diffie_Hellman Base Point: " << _base_point << endl;
 
-        _public = _base_point;
-        _public *= _private;
+        if(table)
+            _public.comb(_private, table);
+        else {
+            _public = _base_point;
+            _public *= _private;
+        }
 
         db<Diffie_Hellman>(INF) << "Diffie_Hellman Public: " << _public << endl;
     }
@@ -94,11 +151,12 @@ private:
     Elliptic_Curve_Point _public;
     static const char _default_base_point_x[SECRET_SIZE];
     static const char _default_base_point_y[SECRET_SIZE];
+    static const unsigned char _default_comb[COMB_POINTS][2][SECRET_SIZE];
 };
 
 //TODO: base point is dependent of SECRET_SIZE
-template<typename Cipher>
-const char Diffie_Hellman<Cipher>::_default_base_point_x[SECRET_SIZE] =
+template<typename Cipher, bool constant_time>
+const char Diffie_Hellman<Cipher, constant_time>::_default_base_point_x[SECRET_SIZE] =
 {
  '\x86', '\x5B', '\x2C', '\xA5',
  '\x7C', '\x60', '\x28', '\x0C',
@@ -106,8 +164,8 @@ const char Diffie_Hellman<Cipher>::_default_base_point_x[SECRET_SIZE] =
  '\x52', '\xF7', '\x1F', '\x16'
 };
 
-template<typename Cipher>
-const char Diffie_Hellman<Cipher>::_default_base_point_y[SECRET_SIZE] =
+template<typename Cipher, bool constant_time>
+const char Diffie_Hellman<Cipher, constant_time>::_default_base_point_y[SECRET_SIZE] =
 {
  '\x83', '\x7A', '\xED', '\xDD',
  '\x92', '\xA2', '\x2D', '\xC0',
@@ -115,52 +173,268 @@ const char Diffie_Hellman<Cipher>::_default_base_point_y[SECRET_SIZE] =
  '\x39', '\xC8', '\x5A', '\xCF'
 };
 
-template<typename Cipher>
-void Diffie_Hellman<Cipher>::Elliptic_Curve_Point::operator*=(const Coordinate & b)
+// Affine (x, y) of sum(bit t of i * 2^(32t) * G) for i = 1 to 15 (the first one is G itself)
+template<typename Cipher, bool constant_time>
+const unsigned char Diffie_Hellman<Cipher, constant_time>::_default_comb[COMB_POINTS][2][SECRET_SIZE] =
 {
-    // Finding last '1' bit of b
-    static const unsigned int bits_in_digit = sizeof(typename Coordinate::Digit) * 8;
+    {{ 0x86, 0x5b, 0x2c, 0xa5, 0x7c, 0x60, 0x28, 0x0c, 0x2d, 0x9b, 0x89, 0x8b, 0x52, 0xf7, 0x1f, 0x16 },
+     { 0x83, 0x7a, 0xed, 0xdd, 0x92, 0xa2, 0x2d, 0xc0, 0x13, 0xeb, 0xaf, 0x5b, 0x39, 0xc8, 0x5a, 0xcf }},
+    {{ 0x2c, 0x43, 0x6a, 0x66, 0xfb, 0xfe, 0x21, 0x5c, 0x01, 0xa2, 0xd4, 0x7e, 0x2b, 0xb3, 0xd4, 0x2a },
+     { 0x6b, 0xca, 0x0c, 0xca, 0x1e, 0xba, 0x90, 0x88, 0x51, 0x0d, 0xe9, 0x6c, 0x5b, 0x13, 0x02, 0xda }},
+    {{ 0x8e, 0xb8, 0x8c, 0x22, 0x9c, 0xb3, 0x78, 0x11, 0xbf, 0x21, 0x16, 0x63, 0x6e, 0xf2, 0x79, 0xfe },
+     { 0xd7, 0x77, 0x9c, 0xad, 0x44, 0xce, 0x99, 0xfa, 0x22, 0xa2, 0x01, 0x7c, 0x66, 0x13, 0x31, 0x78 }},
+    {{ 0xf0, 0x3e, 0xa6, 0x40, 0x01, 0xf2, 0x10, 0x5b, 0xfc, 0x33, 0x28, 0x91, 0x7e, 0x90, 0xb9, 0x8a },
+     { 0x65, 0xcf, 0x3d, 0x6f, 0x3b, 0xdf, 0x13, 0x40, 0x72, 0xce, 0x21, 0x76, 0x33, 0xc2, 0x2f, 0xfa }},
+    {{ 0x4f, 0x8e, 0xdf, 0xe6, 0xae, 0x31, 0x71, 0xda, 0x4c, 0xea, 0xc5, 0x1b, 0x09, 0x2c, 0xef, 0x89 },
+     { 0x7e, 0x0a, 0xf2, 0xc5, 0x8c, 0x59, 0x35, 0x6b, 0x29, 0x2f, 0x59, 0xc3, 0x65, 0x10, 0x64, 0xf6 }},
+    {{ 0xe4, 0x2f, 0xf6, 0x0f, 0xc8, 0x8f, 0xf0, 0x76, 0x54, 0x78, 0xab, 0x09, 0x18, 0x69, 0x54, 0xe0 },
+     { 0xe8, 0xcf, 0x2e, 0xaf, 0xd3, 0xd8, 0x85, 0x1e, 0xab, 0x1b, 0x33, 0xbe, 0xc9, 0xc0, 0x7d, 0x80 }},
+    {{ 0xa3, 0x5e, 0xa6, 0x31, 0x64, 0xb3, 0x96, 0xae, 0xdd, 0x9b, 0xb2, 0xdf, 0x5b, 0x2b, 0xde, 0x25 },
+     { 0x56, 0xca, 0x1e, 0x5d, 0x96, 0xf8, 0x54, 0xa4, 0xca, 0xe2, 0x91, 0xb4, 0x64, 0x2c, 0x5c, 0xa2 }},
+    {{ 0xbb, 0x36, 0x14, 0xec, 0x6e, 0x7f, 0x79, 0xc4, 0xb2, 0x0a, 0x29, 0xe7, 0x56, 0xb4, 0x8f, 0x40 },
+     { 0x8b, 0xe4, 0x23, 0xfc, 0x1a, 0xbb, 0x74, 0x3d, 0xa4, 0x6d, 0xb3, 0x63, 0x6f, 0x7c, 0x9e, 0x9a }},
+    {{ 0x01, 0x54, 0xfa, 0xd5, 0xfc, 0x06, 0xf5, 0x30, 0x5e, 0xa2, 0xa0, 0x2e, 0xfd, 0x79, 0x19, 0xcc },
+     { 0xdf, 0x61, 0x70, 0xf5, 0xb2, 0xa1, 0xb2, 0xb0, 0xc6, 0x93, 0x23, 0xc6, 0x18, 0x2c, 0xb4, 0xd9 }},
+    {{ 0xc1, 0xde, 0x6f, 0x46, 0x96, 0x02, 0x3f, 0xa8, 0x11, 0x44, 0x10, 0x00, 0xd8, 0xe3, 0xb0, 0x0a },
+     { 0x2c, 0xb3, 0x67, 0xcf, 0x10, 0x13, 0xc6, 0xaa, 0xa0, 0x75, 0x2c, 0x71, 0xa6, 0xef, 0xcb, 0x59 }},
+    {{ 0xe6, 0xfa, 0x24, 0x03, 0x0a, 0x8d, 0xef, 0xf9, 0x30, 0xab, 0x56, 0xa1, 0x0e, 0x68, 0x27, 0x5a },
+     { 0x0d, 0x53, 0xbb, 0x65, 0x65, 0x1b, 0xb4, 0x67, 0xfb, 0x68, 0x6d, 0x05, 0x51, 0x5a, 0xc4, 0x58 }},
+    {{ 0xc6, 0x5a, 0x5a, 0x9e, 0x73, 0x6f, 0x47, 0x5b, 0xd6, 0xc7, 0x7a, 0x9c, 0xd0, 0xdb, 0x1a, 0xfd },
+     { 0x05, 0x86, 0xb8, 0x9c, 0x7d, 0x94, 0x13, 0x0f, 0xb6, 0xe9, 0x51, 0xb6, 0xb6, 0x1d, 0x94, 0x07 }},
+    {{ 0x30, 0x6b, 0xf2, 0xb0, 0x09, 0x69, 0xba, 0x60, 0x8d, 0x70, 0x1d, 0xd0, 0x7a, 0x90, 0x0c, 0x8d },
+     { 0x1e, 0x3b, 0x4a, 0x99, 0x35, 0x48, 0x68, 0x12, 0xd7, 0xe4, 0x35, 0xee, 0x8c, 0x89, 0xfb, 0x3e }},
+    {{ 0xd0, 0x99, 0x69, 0xb5, 0x43, 0x40, 0x5f, 0x14, 0x0f, 0xd7, 0xc6, 0x5c, 0xfd, 0xd4, 0xe9, 0xb0 },
+     { 0xb2, 0x9d, 0xa3, 0x09, 0xc4, 0x86, 0x89, 0x8a, 0x23, 0x92, 0x45, 0xe3, 0x35, 0xd9, 0x96, 0x50 }},
+    {{ 0x87, 0x6d, 0xd9, 0x02, 0x90, 0xf9, 0x5e, 0x19, 0xe3, 0x3c, 0x3a, 0x12, 0x96, 0x20, 0xe9, 0xa6 },
+     { 0xfe, 0x09, 0xb2, 0x1e, 0xc6, 0x6a, 0xf9, 0xe6, 0xe9, 0x61, 0x1e, 0x12, 0x6d, 0x3a, 0x0d, 0x5f }}
+};
+
+// Variable-base scalar multiplication: the result is left in affine coordinates (z = 1)
+template<typename Cipher, bool constant_time>
+void Diffie_Hellman<Cipher, constant_time>::Elliptic_Curve_Point::operator*=(const Coordinate & b)
+{
+    if(constant_time)
+        window_multiply(b);
+    else
+        wnaf_multiply(b);
+}
+
+// Lim-Lee comb: bits k_j, k_(j + d), k_(j + 2d) and k_(j + 3d) (d = COMB_SPACING) select one table entry per column j,
+// so the scalar takes d doublings and at most d additions instead of about 4d doublings and 2d additions
+template<typename Cipher, bool constant_time>
+void Diffie_Hellman<Cipher, constant_time>::Elliptic_Curve_Point::comb(const Coordinate & k, const unsigned char (* table)[2][SECRET_SIZE])
+{
+    Elliptic_Curve_Point t[COMB_POINTS + 1]; // t[0] stands for the point at infinity, which is never added
+    for(unsigned int i = 1; i <= COMB_POINTS; i++) {
+        new (&t[i].x) Coordinate(table[i - 1][0], SECRET_SIZE);
+        new (&t[i].y) Coordinate(table[i - 1][1], SECRET_SIZE);
+        t[i].z = 1;
+    }
+    t[0] = t[1];
+
+    bool infinity = true;
+    for(int j = COMB_SPACING - 1; j >= 0; j--) {
+        unsigned int index = 0;
+        for(unsigned int i = 0; i < COMB_TEETH; i++)
+            index |= bit(k, j + i * COMB_SPACING) << i;
+
+        if(constant_time) {
+            jacobian_double();
+            Elliptic_Curve_Point p = lookup(t, COMB_POINTS + 1, index);
+            Elliptic_Curve_Point sum(*this);
+            sum.add_jacobian_affine(p);
+            bool add = (index != 0);
+            select(sum, !infinity & add);
+            select(p, infinity & add);
+            infinity &= !add;
+        } else {
+            if(!infinity)
+                jacobian_double();
+            if(index) {
+                if(infinity)
+                    *this = t[index];
+                else
+                    add_jacobian_affine(t[index]);
+                infinity = false;
+            }
+        }
+    }
 
-    typename Coordinate::Digit now;
-    unsigned int b_len = sizeof(Coordinate) / sizeof(typename Coordinate::Digit);
-    for(; (b_len > 1) && (b[b_len - 1] == 0); b_len--);
-    if((b_len == 0) || (b[b_len - 1] == 0)) {
+    if(infinity) {
         x = 0;
         y = 0;
         z = 0;
         return;
     }
 
-    now = b[b_len - 1];
-
-    bool bin[bits_in_digit]; // Binary representation of 'now'
-    unsigned int current_bit = bits_in_digit;
+    to_affine();
+}
 
-    Elliptic_Curve_Point pp(*this);
+// Left to right over the width-WINDOW NAF of k: one doubling per bit and one addition of a precomputed odd multiple
+// (or of its negative) per non-zero digit, i.e. about one in WINDOW + 1 bits
+template<typename Cipher, bool constant_time>
+void Diffie_Hellman<Cipher, constant_time>::Elliptic_Curve_Point::wnaf_multiply(const Coordinate & k)
+{
+    signed char naf[BITS + 1];
+    unsigned int n = wnaf(naf, k);
+    if(n == 0) {
+        x = 0;
+        y = 0;
+        z = 0;
+        return;
+    }
 
-    for(int i = bits_in_digit - 1; i >= 0; i--) {
-        if(now % 2)
-            current_bit = i + 1;
-        bin[i] = now % 2;
-        now /= 2;
+    Elliptic_Curve_Point t[MULTIPLES]; // t[i] = (2i + 1) * this, in affine coordinates
+    multiples(t, *this, MULTIPLES);
+
+    // The most significant digit is always positive
+    *this = t[naf[n - 1] / 2];
+    for(int i = n - 2; i >= 0; i--) {
+        jacobian_double();
+        if(naf[i] > 0)
+            add_jacobian_affine(t[naf[i] / 2]);
+        else if(naf[i] < 0) {
+            Elliptic_Curve_Point p(t[-naf[i] / 2]);
+            Coordinate minus(0);
+            minus -= p.y;
+            p.y = minus;
+            add_jacobian_affine(p);
+        }
     }
 
-    for(int i = b_len - 1; i >= 0; i--) {
-        for(; current_bit < bits_in_digit; current_bit++) {
+    to_affine();
+}
+
+// Fixed windows of WINDOW bits from the most significant: WINDOW doublings, a full-table lookup and an addition each
+template<typename Cipher, bool constant_time>
+void Diffie_Hellman<Cipher, constant_time>::Elliptic_Curve_Point::window_multiply(const Coordinate & k)
+{
+    Elliptic_Curve_Point t[MULTIPLES + 1]; // t[i] = i * this, in affine coordinates (t[0] stands for the point at infinity)
+    multiples(&t[1], *this, MULTIPLES);
+    t[0] = t[1];
+
+    bool infinity = true;
+    for(int j = BITS - WINDOW; j >= 0; j -= WINDOW) {
+        unsigned int index = 0;
+        for(unsigned int i = 0; i < WINDOW; i++)
+            index |= bit(k, j + i) << i;
+
+        for(unsigned int i = 0; i < WINDOW; i++)
             jacobian_double();
-            if(bin[current_bit])
-                add_jacobian_affine(pp);
+        Elliptic_Curve_Point p = lookup(t, MULTIPLES + 1, index);
+        Elliptic_Curve_Point sum(*this);
+        sum.add_jacobian_affine(p);
+        bool add = (index != 0);
+        select(sum, !infinity & add);
+        select(p, infinity & add);
+        infinity &= !add;
+    }
+
+    Elliptic_Curve_Point zero(0, 0, 0);
+    select(zero, infinity);
+    to_affine();
+}
+
+// table[i] = (i + 1) * p (all of them in constant-time mode) or (2i + 1) * p (the odd ones otherwise), for i < n, in affine coordinates.
+// Each multiple is the double of a smaller one or the sum of the previous one and p (which must be affine), and the
+// conversion to affine coordinates takes a single inversion for the whole table (Montgomery's trick)
+template<typename Cipher, bool constant_time>
+void Diffie_Hellman<Cipher, constant_time>::Elliptic_Curve_Point::multiples(Elliptic_Curve_Point * table, const Elliptic_Curve_Point & p, unsigned int n)
+{
+    static const unsigned int ALL = (1 << WINDOW) - 1;
+    Elliptic_Curve_Point m[ALL + 1]; // m[i] = i * p
+    unsigned int last = constant_time ? n : 2 * n - 1;
+
+    m[1] = p;
+    for(unsigned int i = 2; i <= last; i++) {
+        if(i % 2) {
+            m[i] = m[i - 1];
+            m[i].add_jacobian_affine(p);
+        } else {
+            m[i] = m[i / 2];
+            m[i].jacobian_double();
         }
+    }
+
+    for(unsigned int i = 0; i < n; i++)
+        table[i] = m[constant_time ? i + 1 : 2 * i + 1];
+
+    // prefix[i] = z_0 * ... * z_i, then each inverse is peeled off the inverse of the whole product
+    Coordinate prefix[ALL];
+    prefix[0] = table[0].z;
+    for(unsigned int i = 1; i < n; i++) {
+        prefix[i] = prefix[i - 1];
+        prefix[i] *= table[i].z;
+    }
+    Coordinate inverse(prefix[n - 1]);
+    inverse.invert();
+
+    for(int i = n - 1; i >= 0; i--) {
+        Coordinate zi(inverse), zi2;
         if(i > 0) {
-            now = b[i-1];
-            for(int j = bits_in_digit-1; j >= 0; j--) {
-                bin[j] = now % 2;
-                now /= 2;
-            }
-            current_bit = 0;
+            zi *= prefix[i - 1];
+            inverse *= table[i].z;
         }
+        zi2 = zi;
+        zi2 *= zi;
+        table[i].x *= zi2;
+        zi2 *= zi;
+        table[i].y *= zi2;
+        table[i].z = 1;
     }
+}
 
+// Width-WINDOW NAF of k, least significant digit first: each digit is zero or odd in (-2^(WINDOW - 1), 2^(WINDOW - 1)),
+// and of any WINDOW consecutive digits at most one is non-zero. Returns the number of digits.
+template<typename Cipher, bool constant_time>
+unsigned int Diffie_Hellman<Cipher, constant_time>::Elliptic_Curve_Point::wnaf(signed char * naf, const Coordinate & k)
+{
+    static const unsigned int DIGITS = Bignum::DIGITS;
+    static const unsigned int BITS_PER_DIGIT = Bignum::BITS_PER_DIGIT;
+
+    Digit d[DIGITS + 1]; // one more, for the carry of the negative digits
+    bool zero = true;
+    for(unsigned int i = 0; i < DIGITS; i++) {
+        d[i] = k[i];
+        zero &= !d[i];
+    }
+    d[DIGITS] = 0;
+
+    unsigned int n = 0;
+    while(!zero) {
+        int digit = 0;
+        if(d[0] & 1) {
+            digit = d[0] & ((1 << WINDOW) - 1);
+            if(digit >= (1 << (WINDOW - 1))) {
+                digit -= 1 << WINDOW;
+                // d -= digit (it can carry)
+                Digit carry = -digit;
+                for(unsigned int i = 0; carry && (i <= DIGITS); i++) {
+                    d[i] += carry;
+                    carry = (d[i] < carry);
+                }
+            } else
+                d[0] -= digit; // the lower bits of d are digit itself, so this can't borrow
+        }
+        naf[n++] = digit;
+
+        // d >>= 1
+        zero = true;
+        for(unsigned int i = 0; i < DIGITS; i++) {
+            d[i] = (d[i] >> 1) | (d[i + 1] << (BITS_PER_DIGIT - 1));
+            zero &= !d[i];
+        }
+        d[DIGITS] >>= 1;
+        zero &= !d[DIGITS];
+    }
+
+    return n;
+}
+
+// From Jacobian (X, Y, Z) to affine (X / Z^2, Y / Z^3)
+template<typename Cipher, bool constant_time>
+void Diffie_Hellman<Cipher, constant_time>::Elliptic_Curve_Point::to_affine()
+{
     Coordinate Z;
     z.invert();
     Z = z;
@@ -173,33 +447,34 @@ void Diffie_Hellman<Cipher>::Elliptic_Curve_Point::operator*=(const Coordinate &
     z = 1;
 }
 
-template<typename Cipher>
-void Diffie_Hellman<Cipher>::Elliptic_Curve_Point::jacobian_double()
+// Multiplications by small constants are done as additions
+template<typename Cipher, bool constant_time>
+void Diffie_Hellman<Cipher, constant_time>::Elliptic_Curve_Point::jacobian_double()
 {
     Coordinate B, C(x), aux(z);
 
     aux *= z; C -= aux;
     aux += x; C *= aux;
-    C *= 3;
+    B = C; C += C; C += B;
 
-    z *= y; z *= 2;
+    z *= y; z += z;
 
     y *= y; B = y;
 
-    y *= x; y *= 4;
+    y *= x; y += y; y += y;
 
-    B *= B; B *= 8;
+    B *= B; B += B; B += B; B += B;
 
     x = C; x *= x;
-    aux = y; aux *= 2;
+    aux = y; aux += aux;
     x -= aux;
 
     y -= x; y *= C;
     y -= B;
 }
 
-template<typename Cipher>
-void Diffie_Hellman<Cipher>::Elliptic_Curve_Point::add_jacobian_affine(const Elliptic_Curve_Point &b)
+template<typename Cipher, bool constant_time>
+void Diffie_Hellman<Cipher, constant_time>::Elliptic_Curve_Point::add_jacobian_affine(const Elliptic_Curve_Point &b)
 {
     Coordinate A(z), B, C, X, Y, aux, aux2;
 
@@ -221,7 +496,7 @@ void Diffie_Hellman<Cipher>::Elliptic_Curve_Point::add_jacobian_affine(const Ell
     Y = aux;
 
     aux2 = aux; aux *= C;
-    aux2 *= 2; aux2 *= x;
+    aux2 += aux2; aux2 *= x;
     aux += aux2; X -= aux;
 
     aux = Y; Y *= x;
@@ -0,0 +1,225 @@
+// EPOS Galois/Counter Mode (GCM) Authenticated Encryption Utility Declarations
+
+#ifndef __gcm_h
+#define __gcm_h
+
+#include <utility/string.h>
+#include <utility/aes.h>
+
+__BEGIN_UTIL
+
+// GCM (NIST SP 800-38D) over a 128-bit block cipher with the keyed interface of SWAES (key() and encrypt(in, out)).
+// Data is encrypted or decrypted in place, in as many calls as needed, between start() and tag() or verify().
+// GHASH multiplies by H four bits at a time using a 16-entry table computed when the key is set (Shoup's method).
+// Usage: GCM<> gcm(key); gcm.start(iv, 12, header, header_size); gcm.encrypt(data, size); gcm.tag(tag);
+template<typename Cipher = SWAES<16>>
+class GCM
+{
+private:
+    static const unsigned int BLOCK_SIZE = Cipher::BLOCK_SIZE;
+
+    typedef unsigned long long Half;
+
+public:
+    static const unsigned int TAG_SIZE = 16;
+    static const unsigned int IV_SIZE = 12; // recommended size, any other is hashed into the initial counter
+
+public:
+    GCM(const unsigned char * k) { key(k); }
+
+    void key(const unsigned char * k) {
+        unsigned char h[BLOCK_SIZE];
+        memset(h, 0, BLOCK_SIZE);
+        _cipher.key(k);
+        _cipher.encrypt(h, h);
+
+        // _hh/_hl[i] = i.H, with the 4-bit index read with its most significant bit as the coefficient of x^0
+        Half vh = load(&h[0]), vl = load(&h[8]);
+        _hh[0] = _hl[0] = 0;
+        _hh[8] = vh;
+        _hl[8] = vl;
+        for(unsigned int i = 4; i > 0; i >>= 1) {
+            Half t = (vl & 1) ? 0xe100000000000000ULL : 0;
+            vl = (vh << 63) | (vl >> 1);
+            vh = (vh >> 1) ^ t;
+            _hh[i] = vh;
+            _hl[i] = vl;
+        }
+        for(unsigned int i = 2; i <= 8; i *= 2)
+            for(unsigned int j = 1; j < i; j++) {
+                _hh[i + j] = _hh[i] ^ _hh[j];
+                _hl[i + j] = _hl[i] ^ _hl[j];
+            }
+    }
+
+    void start(const unsigned char * iv, size_t iv_size = IV_SIZE, const unsigned char * aad = 0, size_t aad_size = 0) {
+        memset(_y, 0, BLOCK_SIZE);
+        _offset = 0;
+        _length = 0;
+        _aad_length = aad_size;
+
+        // Pre-counter block J0
+        if(iv_size == IV_SIZE) {
+            memcpy(_j0, iv, IV_SIZE);
+            _j0[12] = _j0[13] = _j0[14] = 0;
+            _j0[15] = 1;
+        } else {
+            memset(_j0, 0, BLOCK_SIZE);
+            absorb(_j0, iv, iv_size);
+            unsigned char lengths[BLOCK_SIZE];
+            memset(lengths, 0, BLOCK_SIZE / 2);
+            store(&lengths[8], static_cast<Half>(iv_size) * 8);
+            absorb(_j0, lengths, BLOCK_SIZE);
+        }
+        memcpy(_counter, _j0, BLOCK_SIZE);
+
+        absorb(_y, aad, aad_size);
+    }
+
+    void encrypt(unsigned char * data, size_t size) { crypt(data, size, true); }
+    void decrypt(unsigned char * data, size_t size) { crypt(data, size, false); }
+
+    void tag(unsigned char * t, unsigned int size = TAG_SIZE) {
+        if(_offset)
+            multiply(_y);
+        _offset = 0;
+
+        unsigned char lengths[BLOCK_SIZE];
+        store(&lengths[0], _aad_length * 8);
+        store(&lengths[8], _length * 8);
+        absorb(_y, lengths, BLOCK_SIZE);
+
+        unsigned char s[BLOCK_SIZE];
+        _cipher.encrypt(_j0, s);
+        for(unsigned int i = 0; i < size; i++)
+            t[i] = s[i] ^ _y[i];
+    }
+
+    // Compares without an early exit, so the time taken does not tell how many bytes matched
+    bool verify(const unsigned char * t, unsigned int size = TAG_SIZE) {
+        unsigned char mine[TAG_SIZE];
+        tag(mine, size);
+        unsigned char diff = 0;
+        for(unsigned int i = 0; i < size; i++)
+            diff |= mine[i] ^ t[i];
+        return !diff;
+    }
+
+private:
+    // Ciphertext is hashed a whole block at a time; a partial block left by one call is completed in the next
+    void crypt(unsigned char * data, size_t size, bool encrypt) {
+        _length += size;
+
+        for(; size && _offset; size--, data++) {
+            if(!encrypt)
+                _y[_offset] ^= *data;
+            *data ^= _stream[_offset];
+            if(encrypt)
+                _y[_offset] ^= *data;
+            if(++_offset == BLOCK_SIZE) {
+                multiply(_y);
+                _offset = 0;
+            }
+        }
+
+        for(; size >= BLOCK_SIZE; size -= BLOCK_SIZE, data += BLOCK_SIZE) {
+            if(!encrypt)
+                for(unsigned int i = 0; i < BLOCK_SIZE; i++)
+                    _y[i] ^= data[i];
+            next();
+            for(unsigned int i = 0; i < BLOCK_SIZE; i++)
+                data[i] ^= _stream[i];
+            if(encrypt)
+                for(unsigned int i = 0; i < BLOCK_SIZE; i++)
+                    _y[i] ^= data[i];
+            multiply(_y);
+        }
+
+        if(size) {
+            next();
+            for(; size; size--, data++, _offset++) {
+                if(!encrypt)
+                    _y[_offset] ^= *data;
+                *data ^= _stream[_offset];
+                if(encrypt)
+                    _y[_offset] ^= *data;
+            }
+        }
+    }
+
+    // Key stream for the next counter block (inc32)
+    void next() {
+        for(int i = BLOCK_SIZE - 1; (i >= 12) && !++_counter[i]; i--);
+        _cipher.encrypt(_counter, _stream);
+    }
+
+    // x = GHASH_H(x, data), padding the last block with zeros
+    void absorb(unsigned char * x, const unsigned char * data, size_t size) {
+        for(; size; ) {
+            unsigned int n = (size < BLOCK_SIZE) ? size : BLOCK_SIZE;
+            for(unsigned int i = 0; i < n; i++)
+                x[i] ^= data[i];
+            multiply(x);
+            data += n;
+            size -= n;
+        }
+    }
+
+    // x = x.H in GF(2^128)
+    void multiply(unsigned char * x) {
+        static const Half last4[16] = {
+            0x0000, 0x1c20, 0x3840, 0x2460, 0x7080, 0x6ca0, 0x48c0, 0x54e0,
+            0xe100, 0xfd20, 0xd940, 0xc560, 0x9180, 0x8da0, 0xa9c0, 0xb5e0 };
+
+        unsigned int lo = x[15] & 0xf;
+        Half zh = _hh[lo], zl = _hl[lo];
+
+        for(int i = 15; i >= 0; i--) {
+            unsigned int hi = x[i] >> 4;
+            lo = x[i] & 0xf;
+
+            if(i != 15) {
+                unsigned int rem = zl & 0xf;
+                zl = (zh << 60) | (zl >> 4);
+                zh = (zh >> 4) ^ (last4[rem] << 48) ^ _hh[lo];
+                zl ^= _hl[lo];
+            }
+
+            unsigned int rem = zl & 0xf;
+            zl = (zh << 60) | (zl >> 4);
+            zh = (zh >> 4) ^ (last4[rem] << 48) ^ _hh[hi];
+            zl ^= _hl[hi];
+        }
+
+        store(&x[0], zh);
+        store(&x[8], zl);
+    }
+
+    static Half load(const unsigned char * b) {
+        Half h = 0;
+        for(unsigned int i = 0; i < 8; i++)
+            h = (h << 8) | b[i];
+        return h;
+    }
+
+    static void store(unsigned char * b, Half h) {
+        for(int i = 7; i >= 0; i--, h >>= 8)
+            b[i] = h;
+    }
+
+private:
+    Cipher _cipher;
+    Half _hh[16];
+    Half _hl[16];
+    unsigned char _j0[BLOCK_SIZE];
+    unsigned char _counter[BLOCK_SIZE];
+    unsigned char _stream[BLOCK_SIZE];
+    unsigned char _y[BLOCK_SIZE];
+    unsigned int _offset;
+    Half _length;
+    Half _aad_length;
+};
+
+__END_UTIL
+
+#endif
@@ -205,6 +205,233 @@ private:
     List _table[SIZE];
 };
 
+
+// Open Addressing Hash Table (linear probing over a flat, growable array)
+// Each slot holds a key and an object pointer, and has a control byte in a separate array: 0 for an empty slot, or
+// 0x80 plus 7 bits of the key's hash for a full one. Probing reads a word of control bytes at a time and compares all
+// of them against the hash bits (and against empty) with a few integer operations (SIMD within a register), so most
+// key comparisons are only made against actual candidates. Removal shifts the rest of the cluster back instead of
+// leaving tombstones, so lookups never get longer with use. Keys are unique and must convert to an unsigned long.
+// The table doubles (with malloc()) whenever it would get more than 3/4 full; insertions and removals invalidate
+// iterators and object pointers held by them.
+template<typename T, typename Key = int>
+class Flat_Hash
+{
+private:
+    typedef unsigned long Group;
+
+    static const unsigned int GROUP = sizeof(Group);
+    static const Group ONES = ~Group(0) / 0xff;
+    static const Group HIGH = ONES * 0x80;
+    static const Group LOW = ONES * 0x7f;
+    static const unsigned char EMPTY = 0;
+    static const unsigned int MIN_CAPACITY = 16;
+
+public:
+    typedef T Object_Type;
+    typedef Key Rank_Type;
+
+    class Slot
+    {
+        friend class Flat_Hash;
+
+    public:
+        T * object() const { return _object; }
+        const Key & key() const { return _key; }
+
+    private:
+        Key _key;
+        T * _object;
+    };
+
+    class Forward
+    {
+    public:
+        Forward(Flat_Hash * hash, unsigned int i): _hash(hash), _index(i) { skip(); }
+
+        Slot & operator*() const { return _hash->_slots[_index]; }
+        Slot * operator->() const { return &_hash->_slots[_index]; }
+
+        Forward & operator++() { _index++; skip(); return *this; }
+        Forward operator++(int) { Forward tmp = *this; ++*this; return tmp; }
+
+        bool operator==(const Forward & i) const { return _index == i._index; }
+        bool operator!=(const Forward & i) const { return _index != i._index; }
+
+    private:
+        void skip() { for(; (_index < _hash->_capacity) && (_hash->_control[_index] == EMPTY); _index++); }
+
+    private:
+        Flat_Hash * _hash;
+        unsigned int _index;
+    };
+
+    typedef Forward Iterator;
+
+public:
+    // Nothing is allocated until the first insertion, so tables can be global objects.
+    // The first allocation holds the expected number of entries without growing
+    Flat_Hash(unsigned int entries = 0): _slots(0), _control(0), _capacity(0), _size(0), _initial(MIN_CAPACITY) {
+        while(_initial * 3 < entries * 4)
+            _initial <<= 1;
+    }
+    ~Flat_Hash() { if(_slots) free(_slots); } // EPOS's free() doesn't take null pointers
+
+    Iterator begin() { return Iterator(this, 0); }
+    Iterator end() { return Iterator(this, _capacity); }
+
+    bool empty() const { return !_size; }
+    unsigned int size() const { return _size; }
+    unsigned int capacity() const { return _capacity; }
+
+    // Fails if the key is already in the table or if it had to grow and there was no memory
+    bool insert(T * object, const Key & key) {
+        if(search_key(key))
+            return false;
+        if(((_size + 1) * 4 > _capacity * 3) && !grow())
+            return false;
+        place(object, key, hash(key));
+        _size++;
+        return true;
+    }
+
+    T * search_key(const Key & key) const {
+        unsigned int i = find(key);
+        return (i < _capacity) ? _slots[i]._object : 0;
+    }
+
+    T * remove_key(const Key & key) {
+        unsigned int i = find(key);
+        if(i >= _capacity)
+            return 0;
+        T * object = _slots[i]._object;
+        erase(i);
+        return object;
+    }
+
+    // Removes object only if it's the one stored under key: O(1), where the chained tables have to scan
+    T * remove(const T * object, const Key & key) {
+        unsigned int i = find(key);
+        if((i >= _capacity) || (_slots[i]._object != object))
+            return 0;
+        erase(i);
+        return const_cast<T *>(object);
+    }
+
+    void clear() {
+        for(unsigned int i = 0; i < _capacity; i++)
+            _control[i] = EMPTY;
+        _size = 0;
+    }
+
+private:
+    // Murmur3's finalizer: the low bits pick the home slot, the top 7 go to the control byte
+    static unsigned int hash(const Key & key) {
+        unsigned long long k = static_cast<unsigned long>(key);
+        unsigned int h = static_cast<unsigned int>(k) ^ static_cast<unsigned int>(k >> 32);
+        h ^= h >> 16;
+        h *= 0x85ebca6b;
+        h ^= h >> 13;
+        h *= 0xc2b2ae35;
+        h ^= h >> 16;
+        return h;
+    }
+    static unsigned char tag(unsigned int h) { return 0x80 | (h >> 25); }
+
+    // The control bytes from i on, with the lowest byte for the lowest address (all supported CPUs are little-endian).
+    // Probes only read whole, aligned Groups: i is a multiple of GROUP and _control starts at a multiple of the capacity
+    Group group(unsigned int i) const { return *reinterpret_cast<const Group *>(&_control[i]); }
+
+    // High bit set in each byte of g that equals t (exactly, with no borrows between bytes)
+    static Group match(Group g, unsigned char t) {
+        Group x = g ^ (ONES * t);
+        return ~(((x & LOW) + LOW) | x | LOW);
+    }
+    static Group match_empty(Group g) { return ~g & HIGH; }
+
+    // Offset of the lowest byte flagged in a mask of high bits (i.e. the number of bytes below it)
+    static unsigned int lowest(Group m) { return ((((m & -m) >> 7) - 1) & ONES) * ONES >> (sizeof(Group) * 8 - 8); }
+
+    unsigned int find(const Key & key) const {
+        if(!_size)
+            return _capacity;
+
+        unsigned int h = hash(key);
+        unsigned char t = tag(h);
+        unsigned int i = h & (_capacity - 1);
+        unsigned int base = i & ~(GROUP - 1);
+        Group skip = ~Group(0) << ((i - base) * 8); // bytes of the first group before the home slot don't belong to the probe
+
+        for(;;) {
+            Group g = group(base);
+            for(Group m = match(g, t) & skip; m; m &= m - 1) {
+                unsigned int j = base + lowest(m);
+                if(_slots[j]._key == key)
+                    return j;
+            }
+            if(match_empty(g) & skip)
+                return _capacity;
+            skip = ~Group(0);
+            base = (base + GROUP) & (_capacity - 1);
+        }
+    }
+
+    void place(T * object, const Key & key, unsigned int h) {
+        unsigned int i = h & (_capacity - 1);
+        for(; _control[i] != EMPTY; i = (i + 1) & (_capacity - 1));
+        _control[i] = tag(h);
+        _slots[i]._key = key;
+        _slots[i]._object = object;
+    }
+
+    // Backward shift deletion (Knuth's Algorithm R): entries after the hole move into it unless that would put them
+    // before their home slot
+    void erase(unsigned int i) {
+        _size--;
+        for(unsigned int j = (i + 1) & (_capacity - 1); _control[j] != EMPTY; j = (j + 1) & (_capacity - 1)) {
+            unsigned int home = hash(_slots[j]._key) & (_capacity - 1);
+            if(((j - home) & (_capacity - 1)) >= ((j - i) & (_capacity - 1))) {
+                _control[i] = _control[j];
+                _slots[i] = _slots[j];
+                i = j;
+            }
+        }
+        _control[i] = EMPTY;
+    }
+
+    bool grow() {
+        unsigned int capacity = _capacity ? _capacity * 2 : _initial;
+        Slot * slots = reinterpret_cast<Slot *>(malloc(capacity * (sizeof(Slot) + 1)));
+        if(!slots)
+            return false;
+
+        Slot * old_slots = _slots;
+        unsigned char * old_control = _control;
+        unsigned int old_capacity = _capacity;
+
+        _slots = slots;
+        _control = reinterpret_cast<unsigned char *>(&slots[capacity]);
+        _capacity = capacity;
+        for(unsigned int i = 0; i < capacity; i++)
+            _control[i] = EMPTY;
+
+        for(unsigned int i = 0; i < old_capacity; i++)
+            if(old_control[i] != EMPTY)
+                place(old_slots[i]._object, old_slots[i]._key, hash(old_slots[i]._key));
+
+        if(old_slots)
+            free(old_slots);
+        return true;
+    }
+
+private:
+    Slot * _slots;
+    unsigned char * _control; // right after the slots, in the same block
+    unsigned int _capacity;
+    unsigned int _size;
+    unsigned int _initial;
+};
+
 __END_UTIL
 
 #endif
@@ -9,12 +9,98 @@
 
 __BEGIN_UTIL
 
+// Heap Statistics (collected only if Traits<Heaps>::monitored)
+template<bool monitored>
+class Heap_Statistics
+{
+public:
+    typedef TSC::Time_Stamp Time_Stamp;
+
+    // Allocation size histogram: bin 0 counts requests up to 16 bytes, bin i those up to 16 << i, the last one everything larger
+    static const unsigned int SIZES = 12;
+
+public:
+    Heap_Statistics(): in_use(0), peak(0), allocations(0), frees(0), failures(0), alloc_time(0), alloc_max(0), free_time(0), free_max(0) {
+        for(unsigned int i = 0; i < SIZES; i++)
+            histogram[i] = 0;
+    }
+
+    static Time_Stamp now() { return TSC::time_stamp(); }
+
+    void allocated(unsigned long requested, unsigned long bytes, const Time_Stamp & start) {
+        Time_Stamp t = now() - start;
+        allocations++;
+        alloc_time += t;
+        if(t > alloc_max)
+            alloc_max = t;
+        in_use += bytes;
+        if(in_use > peak)
+            peak = in_use;
+        unsigned int i = 0;
+        for(unsigned long s = 16; (i < SIZES - 1) && (requested > s); i++, s <<= 1);
+        histogram[i]++;
+    }
+
+    void failed() { failures++; }
+
+    void freed(unsigned long bytes, const Time_Stamp & start) {
+        Time_Stamp t = now() - start;
+        frees++;
+        free_time += t;
+        if(t > free_max)
+            free_max = t;
+        in_use -= bytes;
+    }
+
+    friend OStream & operator<<(OStream & os, const Heap_Statistics & s) {
+        os << "{use=" << s.in_use << ",peak=" << s.peak << ",allocs=" << s.allocations << ",frees=" << s.frees << ",fails=" << s.failures
+           << ",alloc_ts={avg=" << (s.allocations ? s.alloc_time / s.allocations : 0) << ",max=" << s.alloc_max << "}"
+           << ",free_ts={avg=" << (s.frees ? s.free_time / s.frees : 0) << ",max=" << s.free_max << "},sizes={";
+        for(unsigned int i = 0, b = 16; i < SIZES; i++, b <<= 1)
+            os << ((i < SIZES - 1) ? "<=" : ">") << ((i < SIZES - 1) ? b : b >> 1) << ":" << s.histogram[i] << ((i < SIZES - 1) ? "," : "");
+        os << "}}";
+        return os;
+    }
+
+public:
+    unsigned long in_use;               // bytes handed out, including the heap's own headers
+    unsigned long peak;                 // in_use's high-water mark
+    unsigned long allocations;
+    unsigned long frees;
+    unsigned long failures;
+    unsigned long histogram[SIZES];
+    Time_Stamp alloc_time;              // TSC ticks spent in alloc(), accumulated
+    Time_Stamp alloc_max;
+    Time_Stamp free_time;               // TSC ticks spent in free(), accumulated
+    Time_Stamp free_max;
+};
+
+template<>
+class Heap_Statistics<false>
+{
+public:
+    typedef TSC::Time_Stamp Time_Stamp;
+
+public:
+    static Time_Stamp now() { return 0; }
+
+    void allocated(unsigned long requested, unsigned long bytes, const Time_Stamp & start) {}
+    void failed() {}
+    void freed(unsigned long bytes, const Time_Stamp & start) {}
+
+    friend OStream & operator<<(OStream & os, const Heap_Statistics & s) { return os << "{not monitored}"; }
+};
+
+
 // Heap
 class Heap: private Grouping_List<char>
 {
 protected:
     static const bool typed = Traits<System>::multiheap;
 
+public:
+    typedef Heap_Statistics<Traits<Heaps>::monitored> Statistics;
+
 public:
     using Grouping_List<char>::empty;
     using Grouping_List<char>::size;
@@ -36,6 +122,9 @@ public:
         if(!bytes)
             return 0;
 
+        Statistics::Time_Stamp start = Statistics::now();
+        unsigned long requested = bytes;
+
         if(!Traits<CPU>::unaligned_memory_access)
             while((bytes % sizeof(void *)))
                 ++bytes;
@@ -48,6 +137,7 @@ public:
 
         Element * e = search_decrementing(bytes);
         if(!e) {
+            _statistics.failed();
             out_of_memory(bytes);
             return 0;
         }
@@ -58,6 +148,8 @@ public:
             *addr++ = reinterpret_cast<long>(this);
         *addr++ = bytes;
 
+        _statistics.allocated(requested, bytes, start);
+
         db<Heaps>(TRC) << ") => " << reinterpret_cast<void *>(addr) << endl;
 
         return addr;
@@ -77,17 +169,35 @@ public:
         long * addr = reinterpret_cast<long *>(ptr);
         unsigned long bytes = *--addr;
         Heap * heap = reinterpret_cast<Heap *>(*--addr);
-        heap->free(addr, bytes);
+        heap->release(addr, bytes);
     }
 
     static void untyped_free(Heap * heap, void * ptr) {
         long * addr = reinterpret_cast<long *>(ptr);
         unsigned long bytes = *--addr;
-        heap->free(addr, bytes);
+        heap->release(addr, bytes);
     }
 
+    // Fragmentation
+    unsigned long free_blocks() const { return size(); }
+    unsigned long largest_free() const;
+
+    const Statistics & statistics() const { return _statistics; }
+
+    friend OStream & operator<<(OStream & os, const Heap & h);
+
 private:
+    // Gives back a block obtained from alloc() (as opposed to free(), which also adds memory to the heap)
+    void release(void * ptr, unsigned long bytes) {
+        Statistics::Time_Stamp start = Statistics::now();
+        free(ptr, bytes);
+        _statistics.freed(bytes, start);
+    }
+
     void out_of_memory(unsigned long bytes);
+
+private:
+    Statistics _statistics;
 };
 
 __END_UTIL
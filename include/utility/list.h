@@ -1244,6 +1244,7 @@ public:
     bool empty() const { return _list[R::current_queue()].empty(); }
 
     unsigned int size() const { return _list[R::current_queue()].size(); }
+    unsigned int size(unsigned int queue) const { return _list[queue].size(); }
     unsigned int total_size() const {
         unsigned int s = 0;
         for(unsigned int i = 0; i < Q; i++)
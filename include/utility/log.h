@@ -0,0 +1,122 @@
+// EPOS Buffered Log Utility Declarations
+
+// Back end for OStream (and thus for db<>) when Traits<Debug>::buffered is set: output is appended to a ring of the
+// running CPU, with interrupts masked only while it's copied, and written out by drain(), which the idle thread calls.
+// Printing from a critical section then costs a copy instead of a trip through the UART. Each CPU only writes to its
+// own ring, and only drain() reads them, so no locks are taken by writers. Output that doesn't fit is dropped and
+// counted, and drain() reports how much was lost. A panic drains the rings synchronously.
+// The rings take text and binary records (see Binary_Debug) alike; drain() hands them over as is to _print_raw().
+
+#ifndef __log_h
+#define __log_h
+
+#include <architecture/cpu.h>
+#include "per_cpu.h"
+#include "string.h"
+
+extern "C" {
+    void _print_raw(const char * s, unsigned int size);
+}
+
+__BEGIN_UTIL
+
+class Log
+{
+private:
+    static const unsigned int SIZE = Traits<Debug>::buffered ? Traits<Debug>::BUFFER_SIZE : 1;
+    static const unsigned int CHUNK = 64;
+
+    // Head and tail run free, so SIZE must be a power of two
+    struct Ring
+    {
+        volatile unsigned int head; // only written by drain()
+        volatile unsigned int tail; // only written by the ring's CPU
+        volatile unsigned int lost;
+        unsigned int reported;      // only used by drain()
+        char data[SIZE];
+    };
+
+public:
+    static void write(const char * s) { write(s, strlen(s)); }
+
+    static void write(const void * data, unsigned int n) {
+        const char * s = reinterpret_cast<const char *>(data);
+        bool enabled = CPU::int_enabled();
+        CPU::int_disable();
+
+        Ring & r = *_rings;
+        if(n > SIZE - (r.tail - r.head))
+            r.lost += n; // whole pieces are dropped, so nothing that makes it (e.g. a binary record) is ever cut
+        else {
+            unsigned int tail = r.tail;
+            for(unsigned int i = 0; i < n; i++)
+                r.data[(tail + i) & (SIZE - 1)] = s[i];
+            __sync_synchronize(); // the text must be visible to drain() before the new tail
+            r.tail = tail + n;
+        }
+
+        if(enabled)
+            CPU::int_enable();
+    }
+
+    // Writes out what the rings have. Only one caller drains at a time, unless forced (e.g. by a panic)
+    static void drain(bool force = false) {
+        bool owner = !CPU::tsl(_draining);
+        if(!owner && !force)
+            return;
+
+        for(unsigned int i = 0; i < Traits<Build>::CPUS; i++) {
+            Ring & r = _rings[i];
+
+            unsigned int tail = r.tail;
+            __sync_synchronize();
+            while(r.head != tail) {
+                char chunk[CHUNK];
+                unsigned int n = 0;
+                for(unsigned int head = r.head; (head != tail) && (n < CHUNK); head++, n++)
+                    chunk[n] = r.data[head & (SIZE - 1)];
+                __sync_synchronize(); // the chunk must be copied before its space is given back
+                r.head = r.head + n;
+                _print_raw(chunk, n);
+            }
+
+            unsigned int lost = r.lost;
+            if(lost != r.reported) {
+                char msg[48] = "\n<log overflow: ";
+                unsigned int n = strlen(msg);
+                n += utoa(lost - r.reported, &msg[n]);
+                strcpy(&msg[n], " bytes lost>\n");
+                r.reported = lost;
+                _print_raw(msg, n + strlen(&msg[n]));
+            }
+        }
+
+        if(owner) // a forced drain that found another one going on must leave it the flag
+            _draining = 0;
+    }
+
+    // Bytes dropped so far, for all CPUs
+    static unsigned int lost() {
+        unsigned int n = 0;
+        for(unsigned int i = 0; i < Traits<Build>::CPUS; i++)
+            n += _rings[i].lost;
+        return n;
+    }
+
+private:
+    static unsigned int utoa(unsigned int v, char * s) {
+        unsigned int n = 0;
+        for(unsigned int j = v; n == 0 || j; j /= 10, n++);
+        for(unsigned int i = n; i; i--, v /= 10)
+            s[i - 1] = '0' + v % 10;
+        return n;
+    }
+
+private:
+    static Per_CPU<Ring> _rings;
+    static volatile int _draining;
+};
+
+__END_UTIL
+
+#endif
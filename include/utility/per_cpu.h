@@ -0,0 +1,49 @@
+// EPOS Per-CPU Variable Utility Declarations
+
+// Per_CPU<T> keeps a T for each CPU. On multicores, each one sits in cache lines of its own, so CPUs never write to
+// lines other CPUs write to (i.e. there is no false sharing). The running CPU's T is reached with CPU::id(), which
+// single-core configurations fold into a constant, so there they cost just as a plain T.
+// The running CPU's T must only be used while the thread can't migrate (e.g. with interrupts disabled).
+// CPU::id() is used as the index instead of a register holding the base of each CPU's area (tp, TPIDR_EL1, GS),
+// because it's what every architecture in the tree already has: those registers are either taken (tp and GS point to
+// thread-local data in the ABIs) or would have to be saved and set up on every CPU bring-up and exception entry, for a
+// single load saved on a multicore.
+
+#ifndef __per_cpu_h
+#define __per_cpu_h
+
+#include <architecture/cpu.h>
+
+__BEGIN_UTIL
+
+template<typename T>
+class Per_CPU
+{
+private:
+    static const unsigned int CPUS = Traits<Build>::CPUS;
+    static const unsigned int CACHE_LINE = 64;
+    static const unsigned int ALIGNMENT = (CPUS > 1) ? CACHE_LINE : __alignof__(T);
+
+    struct Slot {
+        T value;
+    } __attribute__((aligned(ALIGNMENT)));
+
+public:
+    // The running CPU's
+    T & operator*() { return _slots[cpu()].value; }
+    T * operator->() { return &_slots[cpu()].value; }
+
+    // Any CPU's
+    T & operator[](unsigned int cpu) { return _slots[cpu].value; }
+    const T & operator[](unsigned int cpu) const { return _slots[cpu].value; }
+
+    static unsigned int cpu() { return (CPUS > 1) ? CPU::id() : 0; }
+    static unsigned int size() { return CPUS; }
+
+private:
+    Slot _slots[CPUS];
+};
+
+__END_UTIL
+
+#endif
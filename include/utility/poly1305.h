@@ -4,68 +4,183 @@
 #define __poly1305_h
 
 #include <utility/string.h>
-#include <utility/bignum.h>
-#include <utility/math.h>
 
 __BEGIN_UTIL
 
+// Poly1305-AES (D. J. Bernstein): mac = (((c_1 * r + c_2) * r + ... + c_q) * r % (2^130 - 5) + AES_k(nonce)) % 2^128
+// The accumulator and r are kept in five 26-bit limbs, so each 16-byte block costs 25 32x32->64-bit multiplications and
+// the reductions modulo 2^130 - 5 fold the carries out of the top limb back in times 5. There are no branches or table
+// lookups that depend on the key or on the message, so stamping is constant-time (as long as the Cipher is).
+// A message can be stamped in one call, or streamed: start(nonce), update(data, size) as many times as needed, finish(mac).
 template<typename Cipher>
 class Poly1305
 {
-    typedef _UTIL::Bignum<17> Bignum;
+private:
+    static const unsigned int BLOCK_SIZE = 16;
+    static const unsigned int MASK = 0x3ffffff;
+    static const unsigned int HIBIT = 1 << 24; // 2^128, the 1 appended to each full block, in the fifth limb
+
+public:
+    static const unsigned int MAC_SIZE = 16;
 
 public:
-    Poly1305(const unsigned char k[16], const unsigned char r[16]) : _k(k, 16), _r(r, 16) {
-        clamp();
+    Poly1305(const unsigned char k[16], const unsigned char r[16]) {
+        this->k(k);
+        this->r(r);
     }
     Poly1305() {}
 
     void stamp(unsigned char out[16], const unsigned char nonce[16], const unsigned char * message, int message_len) {
-        // cr = (c_1 * r^q + c_2 * r^(q-1) + ... + c_q * r^1) % (2^130 - 5)
-        Bignum cr(0);
-        for(; message_len > 0; message_len -= 16, message += 16) {
-            int len = Math::min(16, message_len);
-            Bignum c(message, len);
-            reinterpret_cast<unsigned char *>(c._data)[len] = 1;
-
-            cr += c;
-            cr *= _r;
-        }
-
-        unsigned char ciphertext[16];
-        Cipher cipher;
-        cipher.encrypt(nonce, reinterpret_cast<const unsigned char *>(_k._data), ciphertext);
-
-        // out = (cr + aes(k,n)) % 2^128
-        Bignum::simple_add(reinterpret_cast<Bignum::Digit *>(out), reinterpret_cast<const Bignum::Digit *>(ciphertext), cr._data, 4);
+        start(nonce);
+        if(message_len > 0)
+            update(message, message_len);
+        finish(out);
     }
 
+    // Compares without an early exit, so the time taken does not tell how many bytes matched
     bool verify(const unsigned char mac[16], const unsigned char nonce[16], const unsigned char * message, unsigned int message_len) {
         unsigned char my_mac[16];
         stamp(my_mac, nonce, message, message_len);
-        for(int i = 0; i < 16; i++) {
-            if(my_mac[i] != mac[i])
-                return false;
+        unsigned char diff = 0;
+        for(int i = 0; i < 16; i++)
+            diff |= my_mac[i] ^ mac[i];
+        return !diff;
+    }
+
+    void k(const unsigned char k1[16]) { memcpy(_k, k1, 16); }
+
+    // r is clamped (bits 4 to 7 of r[3], r[7], r[11], r[15] and bits 0 and 1 of r[4], r[8], r[12] cleared) while split into limbs
+    void r(const unsigned char r1[16]) {
+        _r[0] = load(&r1[0]) & 0x3ffffff;
+        _r[1] = (load(&r1[3]) >> 2) & 0x3ffff03;
+        _r[2] = (load(&r1[6]) >> 4) & 0x3ffc0ff;
+        _r[3] = (load(&r1[9]) >> 6) & 0x3f03fff;
+        _r[4] = (load(&r1[12]) >> 8) & 0x00fffff;
+    }
+
+    // Streaming interface
+    void start(const unsigned char nonce[16]) {
+        Cipher cipher;
+        cipher.encrypt(nonce, _k, _pad);
+        for(unsigned int i = 0; i < 5; i++)
+            _h[i] = 0;
+        _buffered = 0;
+    }
+
+    void update(const unsigned char * data, size_t size) {
+        if(_buffered) {
+            for(; size && (_buffered < BLOCK_SIZE); size--)
+                _buffer[_buffered++] = *data++;
+            if(_buffered < BLOCK_SIZE)
+                return;
+            blocks(_buffer, BLOCK_SIZE, HIBIT);
+            _buffered = 0;
+        }
+
+        size_t whole = size & ~(BLOCK_SIZE - 1);
+        if(whole) {
+            blocks(data, whole, HIBIT);
+            data += whole;
+            size -= whole;
         }
-        return true;
+
+        for(; size; size--)
+            _buffer[_buffered++] = *data++;
     }
 
-    void k(const unsigned char k1[16]) { new (&_k) Bignum(k1,16); }
-    void r(const unsigned char r1[16]) { new (&_r) Bignum(r1,16); clamp(); }
+    void finish(unsigned char out[16]) {
+        // A last partial block gets its 1 appended as a byte (and is zero padded) instead of at 2^128
+        if(_buffered) {
+            _buffer[_buffered++] = 1;
+            for(; _buffered < BLOCK_SIZE; _buffered++)
+                _buffer[_buffered] = 0;
+            blocks(_buffer, BLOCK_SIZE, 0);
+            _buffered = 0;
+        }
+
+        unsigned int h0 = _h[0], h1 = _h[1], h2 = _h[2], h3 = _h[3], h4 = _h[4], c;
+
+        // Fully carry h
+        c = h1 >> 26; h1 &= MASK;
+        h2 += c; c = h2 >> 26; h2 &= MASK;
+        h3 += c; c = h3 >> 26; h3 &= MASK;
+        h4 += c; c = h4 >> 26; h4 &= MASK;
+        h0 += c * 5; c = h0 >> 26; h0 &= MASK;
+        h1 += c;
+
+        // g = h - p = h + 5 - 2^130, which is selected (with a mask, not a branch) if it didn't go negative
+        unsigned int g0 = h0 + 5; c = g0 >> 26; g0 &= MASK;
+        unsigned int g1 = h1 + c; c = g1 >> 26; g1 &= MASK;
+        unsigned int g2 = h2 + c; c = g2 >> 26; g2 &= MASK;
+        unsigned int g3 = h3 + c; c = g3 >> 26; g3 &= MASK;
+        unsigned int g4 = h4 + c - (1 << 26);
+
+        unsigned int mask = (g4 >> 31) - 1;
+        h0 = (h0 & ~mask) | (g0 & mask);
+        h1 = (h1 & ~mask) | (g1 & mask);
+        h2 = (h2 & ~mask) | (g2 & mask);
+        h3 = (h3 & ~mask) | (g3 & mask);
+        h4 = (h4 & ~mask) | (g4 & mask);
+
+        // out = (h + AES_k(nonce)) % 2^128
+        unsigned long long f;
+        f = static_cast<unsigned long long>(h0 | (h1 << 26)) + load(&_pad[0]);
+        store(&out[0], f);
+        f = static_cast<unsigned long long>((h1 >> 6) | (h2 << 20)) + load(&_pad[4]) + (f >> 32);
+        store(&out[4], f);
+        f = static_cast<unsigned long long>((h2 >> 12) | (h3 << 14)) + load(&_pad[8]) + (f >> 32);
+        store(&out[8], f);
+        f = static_cast<unsigned long long>((h3 >> 18) | (h4 << 8)) + load(&_pad[12]) + (f >> 32);
+        store(&out[12], f);
+    }
 
 private:
-    void clamp() {
-        reinterpret_cast<unsigned char *>(_r._data)[3] &= 15;
-        reinterpret_cast<unsigned char *>(_r._data)[7] &= 15;
-        reinterpret_cast<unsigned char *>(_r._data)[11] &= 15;
-        reinterpret_cast<unsigned char *>(_r._data)[15] &= 15;
-        reinterpret_cast<unsigned char *>(_r._data)[4] &= 252;
-        reinterpret_cast<unsigned char *>(_r._data)[8] &= 252;
-        reinterpret_cast<unsigned char *>(_r._data)[12] &= 252;
+    // h = (h + c) * r % (2^130 - 5) for each block c (with hibit at 2^128), keeping h only partially reduced (limbs up to 2^27)
+    void blocks(const unsigned char * m, size_t size, unsigned int hibit) {
+        const unsigned int r0 = _r[0], r1 = _r[1], r2 = _r[2], r3 = _r[3], r4 = _r[4];
+        const unsigned int s1 = r1 * 5, s2 = r2 * 5, s3 = r3 * 5, s4 = r4 * 5; // 2^130 = 5 (mod p)
+        unsigned int h0 = _h[0], h1 = _h[1], h2 = _h[2], h3 = _h[3], h4 = _h[4];
+
+        for(; size >= BLOCK_SIZE; size -= BLOCK_SIZE, m += BLOCK_SIZE) {
+            h0 += load(&m[0]) & MASK;
+            h1 += (load(&m[3]) >> 2) & MASK;
+            h2 += (load(&m[6]) >> 4) & MASK;
+            h3 += (load(&m[9]) >> 6) & MASK;
+            h4 += (load(&m[12]) >> 8) | hibit;
+
+            unsigned long long d0 = mul(h0, r0) + mul(h1, s4) + mul(h2, s3) + mul(h3, s2) + mul(h4, s1);
+            unsigned long long d1 = mul(h0, r1) + mul(h1, r0) + mul(h2, s4) + mul(h3, s3) + mul(h4, s2);
+            unsigned long long d2 = mul(h0, r2) + mul(h1, r1) + mul(h2, r0) + mul(h3, s4) + mul(h4, s3);
+            unsigned long long d3 = mul(h0, r3) + mul(h1, r2) + mul(h2, r1) + mul(h3, r0) + mul(h4, s4);
+            unsigned long long d4 = mul(h0, r4) + mul(h1, r3) + mul(h2, r2) + mul(h3, r1) + mul(h4, r0);
+
+            unsigned int c;
+            c = d0 >> 26; h0 = d0 & MASK;
+            d1 += c; c = d1 >> 26; h1 = d1 & MASK;
+            d2 += c; c = d2 >> 26; h2 = d2 & MASK;
+            d3 += c; c = d3 >> 26; h3 = d3 & MASK;
+            d4 += c; c = d4 >> 26; h4 = d4 & MASK;
+            h0 += c * 5; c = h0 >> 26; h0 &= MASK;
+            h1 += c;
+        }
+
+        _h[0] = h0; _h[1] = h1; _h[2] = h2; _h[3] = h3; _h[4] = h4;
     }
 
-    Bignum _k;
-    Bignum _r;
+    static unsigned long long mul(unsigned int a, unsigned int b) { return static_cast<unsigned long long>(a) * b; }
+
+    static unsigned int load(const unsigned char * b) {
+        return b[0] | (static_cast<unsigned int>(b[1]) << 8) | (static_cast<unsigned int>(b[2]) << 16) | (static_cast<unsigned int>(b[3]) << 24);
+    }
+    static void store(unsigned char * b, unsigned int w) { b[0] = w; b[1] = w >> 8; b[2] = w >> 16; b[3] = w >> 24; }
+
+private:
+    unsigned char _k[16];
+    unsigned int _r[5];
+    unsigned int _h[5];
+    unsigned char _pad[16]; // AES_k(nonce)
+    unsigned char _buffer[BLOCK_SIZE];
+    unsigned int _buffered;
 };
 
 __END_UTIL
@@ -29,6 +29,11 @@
 // |ord|		| 4 |<--| 3 |<--| 2 |
 // +---+ 		+---+	+---+	+---+
 
+// Ordered Tree Queue is an Ordered Queue kept in a red-black tree (see tree.h).
+// Insertions and removals take O(log n) instead of O(n) steps, which pays off
+// for queues that hold hundreds of elements. Its elements are not exchangeable
+// with those of the lists.
+
 // Scheduling Queue is an ordered queue whose ordering criterion is externally
 // definable and for which selecting methods are defined (e.g. choose). This
 // utility is most useful for schedulers, such as CPU or I/O.
@@ -38,6 +43,7 @@
 
 #include <architecture.h>
 #include "list.h"
+#include "tree.h"
 #include "spin.h"
 
 __BEGIN_UTIL
@@ -88,6 +94,13 @@ template<typename T,
 class Ordered_Queue: public Queue_Wrapper<Ordered_List<T, R, El>, false> {};
 
 
+// Ordered Queue on a Red-Black Tree
+template<typename T,
+          typename R = List_Element_Rank,
+          typename El = Tree_Elements::Red_Black_Ordered<T, R> >
+class Ordered_Tree_Queue: public Queue_Wrapper<Ordered_Tree<T, R, El>, false> {};
+
+
 // Relatively-Ordered Queue
 template<typename T,
           typename R = List_Element_Rank,
@@ -1,36 +1,120 @@
 // EPOS Pseudo Random Number Generator Utility Declarations
 
-// From http://en.wikipedia.org/wiki/Linear_congruential_generator
-// with A = 2 and variable C on a simplification of:
-// X1 = aX0 + c
-// as X1 = (X0 << 1) xor C
+// xoshiro128** by D. Blackman and S. Vigna (http://prng.di.unimi.it): 128 bits of state, period 2^128 - 1, good
+// statistical quality and only shifts, rotations, XORs and two small multiplications per 32-bit number (no division).
+// States are expanded from a seed with SplitMix64, so any seed (including 0) gives a usable generator.
 
 #ifndef __random_h
 #define __random_h
 
-#include <system/config.h>
+#include <architecture/cpu.h>
+#include "per_cpu.h"
 
 __BEGIN_UTIL
 
 class Random
 {
-private:
-    static const unsigned long A = 1103515245;
-    static const unsigned long C = 12345;
-    static const unsigned long M = 4294967295U;
+public:
+    // A generator with its own state, for a thread (or any object) that wants an independent, race-free stream
+    class Generator
+    {
+    public:
+        constexpr Generator(): _s{0x9e3779b9, 0x7f4a7c15, 0xf39cc060, 0x5cedc834} {}
+        Generator(unsigned long long value) { seed(value); }
+
+        void seed(unsigned long long value) {
+            unsigned long long a = splitmix(value);
+            unsigned long long b = splitmix(value);
+            _s[0] = a;
+            _s[1] = a >> 32;
+            _s[2] = b;
+            _s[3] = b >> 32;
+        }
+
+        unsigned int next() {
+            unsigned int result = rotl(_s[1] * 5, 7) * 9;
+            unsigned int t = _s[1] << 9;
+            _s[2] ^= _s[0];
+            _s[3] ^= _s[1];
+            _s[1] ^= _s[2];
+            _s[0] ^= _s[3];
+            _s[2] ^= t;
+            _s[3] = rotl(_s[3], 11);
+            return result;
+        }
+
+        unsigned long long next64() {
+            unsigned long long hi = next();
+            return (hi << 32) | next();
+        }
+
+        // Uniform in [0, bound) without the bias of next() % bound (D. Lemire's multiply-shift with rejection).
+        // A division is only needed when the first low half falls in the short, biased range
+        unsigned int next(unsigned int bound) {
+            unsigned long long m = static_cast<unsigned long long>(next()) * bound;
+            unsigned int l = m;
+            if(l < bound) {
+                unsigned int threshold = -bound % bound;
+                while(l < threshold) {
+                    m = static_cast<unsigned long long>(next()) * bound;
+                    l = m;
+                }
+            }
+            return m >> 32;
+        }
+
+        // Uniform in [min, max]
+        int next(int min, int max) { return min + static_cast<int>(next(static_cast<unsigned int>(max - min) + 1)); }
+
+        // Fills size bytes at buffer, four per number
+        void fill(void * buffer, size_t size) {
+            unsigned char * p = reinterpret_cast<unsigned char *>(buffer);
+            for(; size >= sizeof(unsigned int); size -= sizeof(unsigned int), p += sizeof(unsigned int)) {
+                unsigned int r = next();
+                p[0] = r;
+                p[1] = r >> 8;
+                p[2] = r >> 16;
+                p[3] = r >> 24;
+            }
+            if(size)
+                for(unsigned int r = next(); size; size--, r >>= 8)
+                    *p++ = r;
+        }
+
+    private:
+        static unsigned int rotl(unsigned int x, unsigned int k) { return (x << k) | (x >> (32 - k)); }
+
+        static unsigned long long splitmix(unsigned long long & x) {
+            unsigned long long z = (x += 0x9e3779b97f4a7c15ULL);
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+            return z ^ (z >> 31);
+        }
+
+    private:
+        unsigned int _s[4];
+    };
 
 public:
-    static int random() {
-        _seed = ((_seed * A) + C) % M; //_seed = (_seed << 1) ^ n;
-        return _seed;
-    }
+    // The shared interface draws from the running CPU's generator, with no locks. A thread preempted in the middle of a
+    // draw may make another one on the same CPU repeat a number, which is harmless for backoff and jitter; threads that
+    // need independent streams should have Generators of their own
+    static int random() { return generator().next(); }
+    static unsigned int random(unsigned int bound) { return generator().next(bound); }
+    static int random(int min, int max) { return generator().next(min, max); }
+    static void fill(void * buffer, size_t size) { generator().fill(buffer, size); }
 
-    static void seed(int value) {
-        _seed = value;
+    // Each CPU gets a different stream from the same seed
+    static void seed(unsigned long long value) {
+        for(unsigned int i = 0; i < Traits<Build>::CPUS; i++)
+            _generators[i].seed(value + i);
     }
 
 private:
-    static int _seed;
+    static Generator & generator() { return *_generators; }
+
+private:
+    static Per_CPU<Generator> _generators; // so CPUs drawing numbers don't bounce cache lines among them
 };
 
 __END_UTIL
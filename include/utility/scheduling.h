@@ -13,7 +13,12 @@ __BEGIN_UTIL
 
 // Scheduling_Queue
 template<typename T, typename R = typename T::Criterion>
-class Scheduling_Queue: public Scheduling_List<T> {};
+class Scheduling_Queue: public Scheduling_List<T>
+{
+public:
+    // Load balancing, for criteria with a queue per CPU; there's nothing to balance in a single queue
+    typename Scheduling_List<T>::Element * steal() { return 0; }
+};
 
 
 // Scheduler
@@ -93,6 +98,17 @@ public:
         return obj;
     }
 
+    // Takes an object from another CPU's queue to the running CPU's one (see Scheduling_Queue::steal())
+    T * steal() {
+        Element * e = Base::steal();
+        if(!e)
+            return 0;
+
+        db<Scheduler>(TRC) << "Scheduler[chosen=" << chosen() << "]::steal() => " << e->object() << endl;
+
+        return e->object();
+    }
+
     T * choose(T * obj) {
         db<Scheduler>(TRC) << "Scheduler[chosen=" << chosen() << "]::choose(" << obj;
 
@@ -0,0 +1,383 @@
+// EPOS Tree Utility Declarations
+
+// Ordered_Tree keeps elements ordered by rank, just like Ordered_List, but in a red-black tree, so insertions and
+// removals take O(log n) instead of O(n) steps. Elements are also threaded in rank order (prev() and next()), so the
+// head, the tail and the removal of the head are O(1), and the iterators of the lists work on trees unchanged.
+// Elements with the same rank keep the order in which they were inserted, as in Ordered_List.
+
+#ifndef __tree_h
+#define __tree_h
+
+#include <system/config.h>
+#include "list.h"
+
+__BEGIN_UTIL
+
+// Tree Elements
+namespace Tree_Elements
+{
+    typedef List_Element_Rank Rank;
+
+    // Ordered Tree Element
+    template<typename T, typename R = Rank>
+    class Red_Black_Ordered
+    {
+    public:
+        typedef T Object_Type;
+        typedef R Rank_Type;
+        typedef Red_Black_Ordered Element;
+
+    public:
+        Red_Black_Ordered(const T * o, const R & r = 0): _object(o), _rank(r), _prev(0), _next(0), _parent(0), _left(0), _right(0), _red(false) {}
+
+        T * object() const { return const_cast<T *>(_object); }
+
+        Element * prev() const { return _prev; }
+        Element * next() const { return _next; }
+        void prev(Element * e) { _prev = e; }
+        void next(Element * e) { _next = e; }
+
+        Element * parent() const { return _parent; }
+        Element * left() const { return _left; }
+        Element * right() const { return _right; }
+        void parent(Element * e) { _parent = e; }
+        void left(Element * e) { _left = e; }
+        void right(Element * e) { _right = e; }
+
+        bool red() const { return _red; }
+        void red(bool r) { _red = r; }
+
+        // The rank of an element must not be changed while it is in a tree
+        const R & rank() const { return _rank; }
+        void rank(const R & r) { _rank = r; }
+        int promote(const R & n = 1) { _rank -= n; return _rank; }
+        int demote(const R & n = 1) { _rank += n; return _rank; }
+
+    private:
+        const T * _object;
+        R _rank;
+        Element * _prev;
+        Element * _next;
+        Element * _parent;
+        Element * _left;
+        Element * _right;
+        bool _red;
+    };
+};
+
+
+// Red-Black, Ordered Tree
+template<typename T,
+          typename R = List_Element_Rank,
+          typename El = Tree_Elements::Red_Black_Ordered<T, R> >
+class Ordered_Tree
+{
+public:
+    typedef T Object_Type;
+    typedef R Rank_Type;
+    typedef El Element;
+    typedef List_Iterators::Bidirecional<El> Iterator;
+
+public:
+    Ordered_Tree(): _size(0), _root(0), _head(0), _tail(0) {}
+
+    bool empty() const { return (_size == 0); }
+    unsigned int size() const { return _size; }
+
+    Element * head() { return _head; }
+    Element * tail() { return _tail; }
+
+    Iterator begin() { return Iterator(_head); }
+    Iterator end() { return Iterator(0); }
+
+    void insert(Element * e) {
+        db<Lists>(TRC) << "Ordered_Tree::insert(e=" << e << ",o=" << e->object() << ",r=" << e->rank() << ")" << endl;
+
+        // Equal ranks go right, after the ones already there
+        Element * parent = 0;
+        bool left = false;
+        for(Element * n = _root; n; n = left ? n->left() : n->right()) {
+            parent = n;
+            left = e->rank() < n->rank();
+        }
+
+        e->parent(parent);
+        e->left(0);
+        e->right(0);
+        e->red(true);
+        _size++;
+
+        // A new left child comes right before its parent, a right one right after it
+        if(!parent) {
+            _root = e;
+            link(e, 0, 0);
+        } else if(left) {
+            parent->left(e);
+            link(e, parent->prev(), parent);
+        } else {
+            parent->right(e);
+            link(e, parent, parent->next());
+        }
+
+        insert_fixup(e);
+    }
+
+    Element * remove() {
+        db<Lists>(TRC) << "Ordered_Tree::remove()" << endl;
+        return _head ? remove(_head) : 0;
+    }
+
+    Element * remove(Element * e) {
+        db<Lists>(TRC) << "Ordered_Tree::remove(e=" << e << ",o=" << e->object() << ",r=" << e->rank() << ")" << endl;
+
+        Element * x;         // the node that takes the place of the one taken out of the tree (maybe none)
+        Element * x_parent;
+        bool red = e->red(); // color of the node taken out of the tree
+
+        if(!e->left() || !e->right()) {
+            x = e->left() ? e->left() : e->right();
+            x_parent = e->parent();
+            transplant(e, x);
+        } else {
+            // e has two children, so its successor (the leftmost node of its right subtree) takes its place
+            Element * y = e->next();
+            red = y->red();
+            x = y->right();
+            if(y->parent() == e)
+                x_parent = y;
+            else {
+                x_parent = y->parent();
+                transplant(y, x);
+                y->right(e->right());
+                y->right()->parent(y);
+            }
+            transplant(e, y);
+            y->left(e->left());
+            y->left()->parent(y);
+            y->red(e->red());
+        }
+
+        if(!red)
+            remove_fixup(x, x_parent);
+
+        unlink(e);
+        _size--;
+
+        return e;
+    }
+
+    Element * remove(const Object_Type * obj) {
+        db<Lists>(TRC) << "Ordered_Tree::remove(o=" << obj << ")" << endl;
+
+        Element * e = search(obj);
+        if(e)
+            return remove(e);
+        else
+            return 0;
+    }
+
+    Element * search(const Object_Type * obj) {
+        Element * e = _head;
+        for(; e && (e->object() != obj); e = e->next());
+        return e;
+    }
+
+    // The first element (in order) with the given rank
+    Element * search_rank(const Rank_Type & rank) {
+        Element * found = 0;
+        for(Element * n = _root; n; )
+            if(rank < n->rank())
+                n = n->left();
+            else if(n->rank() < rank)
+                n = n->right();
+            else {
+                found = n;
+                n = n->left();
+            }
+        return found;
+    }
+
+    Element * remove_rank(const Rank_Type & rank) {
+        db<Lists>(TRC) << "Ordered_Tree::remove_rank(r=" << rank << ")" << endl;
+
+        Element * e = search_rank(rank);
+        if(e)
+            return remove(e);
+        return 0;
+    }
+
+private:
+    void link(Element * e, Element * prev, Element * next) {
+        e->prev(prev);
+        e->next(next);
+        if(prev)
+            prev->next(e);
+        else
+            _head = e;
+        if(next)
+            next->prev(e);
+        else
+            _tail = e;
+    }
+
+    void unlink(Element * e) {
+        if(e->prev())
+            e->prev()->next(e->next());
+        else
+            _head = e->next();
+        if(e->next())
+            e->next()->prev(e->prev());
+        else
+            _tail = e->prev();
+        e->prev(0);
+        e->next(0);
+    }
+
+    // Puts v (which may be null) where u is in the tree
+    void transplant(Element * u, Element * v) {
+        if(!u->parent())
+            _root = v;
+        else if(u == u->parent()->left())
+            u->parent()->left(v);
+        else
+            u->parent()->right(v);
+        if(v)
+            v->parent(u->parent());
+    }
+
+    void rotate_left(Element * x) {
+        Element * y = x->right();
+        x->right(y->left());
+        if(y->left())
+            y->left()->parent(x);
+        transplant(x, y);
+        y->left(x);
+        x->parent(y);
+    }
+
+    void rotate_right(Element * x) {
+        Element * y = x->left();
+        x->left(y->right());
+        if(y->right())
+            y->right()->parent(x);
+        transplant(x, y);
+        y->right(x);
+        x->parent(y);
+    }
+
+    static bool red(Element * e) { return e && e->red(); }
+
+    // Restores the red-black properties after inserting the red node e (Cormen et al.)
+    void insert_fixup(Element * e) {
+        Element * p;
+        while((p = e->parent()) && p->red()) {
+            Element * g = p->parent(); // p is red, so it's not the root
+            if(p == g->left()) {
+                Element * u = g->right();
+                if(red(u)) {
+                    p->red(false);
+                    u->red(false);
+                    g->red(true);
+                    e = g;
+                } else {
+                    if(e == p->right()) {
+                        rotate_left(p);
+                        p = e;
+                    }
+                    p->red(false);
+                    g->red(true);
+                    rotate_right(g);
+                    break;
+                }
+            } else {
+                Element * u = g->left();
+                if(red(u)) {
+                    p->red(false);
+                    u->red(false);
+                    g->red(true);
+                    e = g;
+                } else {
+                    if(e == p->left()) {
+                        rotate_right(p);
+                        p = e;
+                    }
+                    p->red(false);
+                    g->red(true);
+                    rotate_left(g);
+                    break;
+                }
+            }
+        }
+        _root->red(false);
+    }
+
+    // Restores the red-black properties after a black node was taken out from above x (which may be null, so its
+    // parent is also given). The sibling of x can't be null, since it must account for the black node removed
+    void remove_fixup(Element * x, Element * parent) {
+        while((x != _root) && !red(x)) {
+            if(x == parent->left()) {
+                Element * w = parent->right();
+                if(w->red()) {
+                    w->red(false);
+                    parent->red(true);
+                    rotate_left(parent);
+                    w = parent->right();
+                }
+                if(!red(w->left()) && !red(w->right())) {
+                    w->red(true);
+                    x = parent;
+                    parent = x->parent();
+                } else {
+                    if(!red(w->right())) {
+                        w->left()->red(false);
+                        w->red(true);
+                        rotate_right(w);
+                        w = parent->right();
+                    }
+                    w->red(parent->red());
+                    parent->red(false);
+                    w->right()->red(false);
+                    rotate_left(parent);
+                    x = _root;
+                }
+            } else {
+                Element * w = parent->left();
+                if(w->red()) {
+                    w->red(false);
+                    parent->red(true);
+                    rotate_right(parent);
+                    w = parent->left();
+                }
+                if(!red(w->left()) && !red(w->right())) {
+                    w->red(true);
+                    x = parent;
+                    parent = x->parent();
+                } else {
+                    if(!red(w->left())) {
+                        w->right()->red(false);
+                        w->red(true);
+                        rotate_left(w);
+                        w = parent->left();
+                    }
+                    w->red(parent->red());
+                    parent->red(false);
+                    w->left()->red(false);
+                    rotate_right(parent);
+                    x = _root;
+                }
+            }
+        }
+        if(x)
+            x->red(false);
+    }
+
+private:
+    unsigned int _size;
+    Element * _root;
+    Element * _head;
+    Element * _tail;
+};
+
+__END_UTIL
+
+#endif
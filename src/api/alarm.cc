@@ -10,13 +10,17 @@ __BEGIN_SYS
 Alarm_Timer * Alarm::_timer;
 volatile Alarm::Tick Alarm::_elapsed;
 Alarm::Queue Alarm::_request;
+volatile unsigned int Alarm::_dispatches;
+Alarm::Events Alarm::_events;
+volatile Alarm::Time_Stamp Alarm::_latency;
 
-Alarm::Alarm(const Microsecond & time, Handler * handler, unsigned int times)
-: _time(time), _handler(handler), _times(times), _ticks(ticks(time)), _link(this, _ticks)
+// Alarms are queued by their latest times (i.e. with the slack), so the one at the head sets when alarms go off
+Alarm::Alarm(const Microsecond & time, Handler * handler, unsigned int times, const Microsecond & slack)
+: _time(time), _handler(handler), _times(times), _ticks(ticks(time)), _slack(slack_ticks(slack)), _link(this, _ticks + _slack)
 {
     lock();
 
-    db<Alarm>(TRC) << "Alarm(t=" << time << ",tk=" << _ticks << ",h=" << reinterpret_cast<void *>(handler) << ",x=" << times << ") => " << this << endl;
+    db<Alarm>(TRC) << "Alarm(t=" << time << ",tk=" << _ticks << ",h=" << reinterpret_cast<void *>(handler) << ",x=" << times << ",s=" << _slack << ") => " << this << endl;
 
     if(_ticks) {
         _request.insert(&_link);
@@ -48,7 +52,7 @@ void Alarm::reset()
     db<Alarm>(TRC) << "Alarm::reset(this=" << this << ")" << endl;
 
     _request.remove(this);
-    _link.rank(_ticks);
+    _link.rank(_ticks + _slack);
     _request.insert(&_link);
 
     if(!locked)
@@ -66,6 +70,24 @@ void Alarm::period(const Microsecond & p)
     _request.remove(this);
     _time = p;
     _ticks = ticks(p);
+    _link.rank(_ticks + _slack);
+    _request.insert(&_link);
+
+    if(!locked)
+        unlock();
+}
+
+void Alarm::slack(const Microsecond & s)
+{
+    bool locked = Thread::locked();
+    if(!locked)
+        lock();
+
+    db<Alarm>(TRC) << "Alarm::slack(this=" << this << ",s=" << s << ")" << endl;
+
+    _request.remove(this);
+    _slack = slack_ticks(s);
+    _link.rank(_ticks + _slack);
     _request.insert(&_link);
 
     if(!locked)
@@ -77,6 +99,15 @@ void Alarm::delay(const Microsecond & time)
 {
     db<Alarm>(TRC) << "Alarm::delay(time=" << time << ")" << endl;
 
+    // Nothing is measured here, but the estimate must come down even if no one waits for events
+    calibrate(0);
+
+    // A sleep wouldn't end any sooner
+    if(time_stamp(time) <= _latency) {
+        spin(TSC::time_stamp() + time_stamp(time));
+        return;
+    }
+
     Semaphore semaphore(0);
     Semaphore_Handler handler(&semaphore);
     Alarm alarm(time, &handler, 1); // if time < tick trigger v()
@@ -84,6 +115,55 @@ void Alarm::delay(const Microsecond & time)
 }
 
 
+// With one-shot events on the Alarm_Timer, the thread is woken up at the time stamp it asked for. Otherwise, it sleeps
+// in whole ticks, which end no later than that, and the spin takes up to a tick more.
+void Alarm::delay_until(const Time_Stamp & deadline)
+{
+    db<Alarm>(TRC) << "Alarm::delay_until(d=" << deadline << ")" << endl;
+
+    Time_Stamp now = TSC::time_stamp();
+    if(deadline > now + _latency) {
+        Time_Stamp wakeup = deadline - _latency;
+        Semaphore semaphore(0);
+
+        if(Alarm_Timer::events) {
+            Events::Element e(&semaphore, wakeup);
+
+            lock();
+            _events.insert(&e);
+            if(_events.head() == &e)
+                _timer->event(wakeup);
+            unlock();
+
+            semaphore.p(); // the latency is measured by event_handler()
+        } else {
+            calibrate(0); // ticks can't tell how late their interrupts are, so the estimate only comes down
+            Tick ticks = (wakeup - now) / time_stamp(timer_period());
+            if(ticks) {
+                Semaphore_Handler handler(&semaphore);
+                Alarm alarm(ticks * timer_period(), &handler, 1);
+                semaphore.p();
+            }
+        }
+    }
+
+    spin(deadline);
+}
+
+
+// The latency estimate follows increases at once, and decreases slowly. It's capped at a tick, so an odd interrupt that
+// got held up (e.g. by a long critical section) can't make delays of up to a quantum busy
+void Alarm::calibrate(const Time_Stamp & measured)
+{
+    Time_Stamp late = (measured < time_stamp(timer_period())) ? measured : time_stamp(timer_period());
+    Time_Stamp latency = _latency;
+    if(late > latency)
+        _latency = late;
+    else
+        _latency = latency - (latency - late) / 8;
+}
+
+
 void Alarm::handler(IC::Interrupt_Id i)
 {
     lock();
@@ -99,28 +179,75 @@ void Alarm::handler(IC::Interrupt_Id i)
         display.position(lin, col);
     }
 
-    Alarm * alarm = 0;
-
-    if(!_request.empty()) {
-        // Replacing the following "if" by a "while" loop is tempting, but recovering the lock and dispatching the handler is
-        // troublesome if the Alarm gets destroyed in between, like is the case for the idle thread returning to shutdown the machine
-        if(_request.head()->promote() <= 0) { // rank can be negative whenever multiple handlers get created for the same time tick
-            Queue::Element * e = _request.remove();
-            alarm = e->object();
-            if(alarm->_times != INFINITE)
-                alarm->_times--;
-            if(alarm->_times > 0) {
-                e->rank(alarm->_ticks);
-                _request.insert(e);
+    // Alarms go off when the one at the head reaches its latest time, and so do all the others that are past their own
+    // times (i.e. their latest ones minus their slack). Handlers are called one at a time, after the lock is released,
+    // since each might switch threads. The queue is searched again for the next one, since alarms might have come or
+    // gone in between (like the idle thread's, which returns to shutdown the machine).
+    bool due = !_request.empty() && (_request.head()->promote() <= 0); // ranks can be negative when many alarms are due at once
+    if(due)
+        _dispatches++;
+
+    while(due) {
+        Alarm * alarm = 0;
+        Tick base = 0;
+        for(Queue::Element * e = _request.head(); e; e = e->next()) {
+            Tick time = base + e->rank(); // the relative ranks of the ones after e keep the same sum if e is removed
+            if(time - e->object()->_slack <= 0) {
+                alarm = _request.remove(e)->object();
+                break;
             }
+            base = time;
+        }
+
+        if(!alarm)
+            break;
+
+        Handler * handler = alarm->_handler;
+        if(alarm->_times != INFINITE)
+            alarm->_times--;
+        if(alarm->_times > 0) {
+            alarm->_link.rank(alarm->_ticks + alarm->_slack);
+            _request.insert(&alarm->_link);
         }
+
+        unlock();
+
+        db<Alarm>(TRC) << "Alarm::handler(this=" << alarm << ",e=" << _elapsed << ",h=" << reinterpret_cast<void*>(handler) << ")" << endl;
+        (*handler)();
+
+        lock();
     }
 
     unlock();
+}
+
+// Wakes up the threads whose events are due, one at a time, since each v() might switch threads. How late the interrupt
+// came for the first one is the latency estimate's sample (scheduling delays after the v() aren't, since they are
+// covered by the spin and would make short delays busy for no gain)
+void Alarm::event_handler(IC::Interrupt_Id i)
+{
+    bool sampled = false;
+    while(true) {
+        lock();
+
+        Semaphore * semaphore = 0;
+        Time_Stamp now = TSC::time_stamp();
+        if(!_events.empty() && (_events.head()->rank() <= now)) {
+            if(!sampled) {
+                calibrate(now - _events.head()->rank());
+                sampled = true;
+            }
+            semaphore = _events.remove()->object();
+            _timer->event(_events.empty() ? ~Time_Stamp(0) : _events.head()->rank());
+        }
+
+        unlock();
+
+        if(!semaphore)
+            break;
 
-    if(alarm) {
-        db<Alarm>(TRC) << "Alarm::handler(this=" << alarm << ",e=" << _elapsed << ",h=" << reinterpret_cast<void*>(alarm->handler) << ")" << endl;
-        (*alarm->_handler)();
+        db<Alarm>(TRC) << "Alarm::event_handler(s=" << semaphore << ")" << endl;
+        semaphore->v();
     }
 }
 
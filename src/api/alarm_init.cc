@@ -9,7 +9,8 @@ void Alarm::init()
 {
     db<Init, Alarm>(TRC) << "Alarm::init()" << endl;
 
-    _timer = new (SYSTEM) Alarm_Timer(handler);
+    _timer = new (SYSTEM) Alarm_Timer(handler, event_handler);
+    _latency = time_stamp(LATENCY);
 }
 
 __END_SYS
@@ -0,0 +1,149 @@
+// EPOS Arena (Region Allocator) Implementation
+
+#include <memory.h>
+#include <system.h>
+
+__BEGIN_SYS
+
+// Methods
+Arena::Arena(unsigned int chunk_size): _parent(0), _segment(0), _chunk_size(clamp(chunk_size)), _chunk(0), _top(0), _end(0)
+{
+    db<Arena>(TRC) << "Arena(cs=" << chunk_size << ") => " << this << endl;
+}
+
+
+Arena::Arena(Segment * segment): _parent(0), _segment(segment), _chunk_size(0), _chunk(0), _top(0), _end(0)
+{
+    char * addr = Address_Space(MMU::current()).attach(_segment);
+
+    db<Arena>(TRC) << "Arena(seg=" << segment << " @ " << reinterpret_cast<void *>(addr) << ") => " << this << endl;
+
+    if(addr && (_segment->size() > sizeof(Chunk))) {
+        _chunk = new (addr) Chunk;
+        _chunk->next = 0;
+        _chunk->end = addr + _segment->size();
+        _top = base(_chunk);
+        _end = _chunk->end;
+    } else
+        db<Arena>(WRN) << "Arena(seg=" << segment << "): could not attach the segment!" << endl;
+}
+
+
+Arena::Arena(Arena * parent, unsigned int chunk_size): _parent(parent), _segment(0), _chunk_size(clamp(chunk_size)), _chunk(0), _top(0), _end(0)
+{
+    db<Arena>(TRC) << "Arena(parent=" << parent << ",cs=" << chunk_size << ") => " << this << endl;
+}
+
+
+Arena::~Arena()
+{
+    db<Arena>(TRC) << "~Arena(this=" << this << ",chunks=" << chunks() << ",used=" << used() << ")" << endl;
+
+    if(_segment) {
+        if(_chunk)
+            Address_Space(MMU::current()).detach(_segment);
+    } else {
+        Mark none = { 0, 0 };
+        release(none);
+    }
+}
+
+
+void Arena::release(const Mark & m)
+{
+    db<Arena>(TRC) << "Arena::release(this=" << this << ",m={c=" << m.chunk << ",t=" << reinterpret_cast<void *>(m.top) << "})" << endl;
+
+    // A mark is only good while its chunk is still ours (e.g. not after a reset() or an outer release())
+    assert(!m.chunk || holds(m.chunk));
+
+    while(_chunk != m.chunk) {
+        Chunk * c = _chunk;
+        _chunk = c->next;
+        drop(c);
+    }
+    _top = m.top;
+    _end = _chunk ? _chunk->end : 0;
+}
+
+
+void Arena::reset()
+{
+    db<Arena>(TRC) << "Arena::reset(this=" << this << ")" << endl;
+
+    // Keep the first chunk, so a reused arena doesn't go back to its source for every request
+    Chunk * first = _chunk;
+    while(first && first->next)
+        first = first->next;
+
+    Mark m = { first, first ? base(first) : 0 };
+    release(m);
+}
+
+
+unsigned int Arena::chunks() const
+{
+    unsigned int n = 0;
+    for(Chunk * c = _chunk; c; c = c->next)
+        n++;
+    return n;
+}
+
+
+unsigned long Arena::used() const
+{
+    if(!_chunk)
+        return 0;
+
+    unsigned long bytes = _top - base(_chunk);
+    for(Chunk * c = _chunk->next; c; c = c->next)
+        bytes += c->top - base(c);
+    return bytes;
+}
+
+
+void * Arena::grow(unsigned int bytes)
+{
+    if(_segment) {
+        db<Arena>(WRN) << "Arena::alloc(this=" << this << ",bytes=" << bytes << "): segment exhausted!" << endl;
+        return 0;
+    }
+
+    unsigned int size = sizeof(Chunk) + ((bytes > _chunk_size - sizeof(Chunk)) ? bytes : _chunk_size - sizeof(Chunk));
+    char * addr = _parent ? reinterpret_cast<char *>(_parent->alloc(size)) : new (SYSTEM) char[size];
+
+    db<Arena>(TRC) << "Arena::grow(this=" << this << ",bytes=" << bytes << ") => " << reinterpret_cast<void *>(addr) << endl;
+
+    if(!addr)
+        return 0;
+
+    if(_chunk)
+        _chunk->top = _top;
+
+    Chunk * c = new (addr) Chunk;
+    c->next = _chunk;
+    c->end = addr + size;
+    _chunk = c;
+    _top = base(c) + bytes;
+    _end = c->end;
+
+    return base(c);
+}
+
+
+bool Arena::holds(Chunk * chunk) const
+{
+    for(Chunk * c = _chunk; c; c = c->next)
+        if(c == chunk)
+            return true;
+    return false;
+}
+
+
+void Arena::drop(Chunk * chunk)
+{
+    // Chunks from a parent arena go back with the parent's own release
+    if(!_parent && !_segment)
+        delete [] reinterpret_cast<char *>(chunk);
+}
+
+__END_SYS
@@ -11,6 +11,12 @@ Segment::Segment(unsigned int bytes, Flags flags): Chunk(bytes, flags, WHITE)
 }
 
 
+Segment::Segment(unsigned int bytes, const Color & color, Flags flags): Chunk(bytes, flags, color)
+{
+    db<Segment>(TRC) << "Segment(bytes=" << bytes << ",color=" << color << ",flags=" << flags << ") [Chunk::pt=" << Chunk::pt() << ",sz=" << Chunk::size() << "] => " << this << endl;
+}
+
+
 Segment::Segment(Phy_Addr phy_addr, unsigned int bytes, Flags flags): Chunk(phy_addr, bytes, flags | Flags::IO)
 // The MMU::IO flag signalizes the MMU that the attached memory shall
 // not be released when the chunk is deleted
@@ -37,6 +43,12 @@ Segment::Phy_Addr Segment::phy_address() const
 }
 
 
+Color Segment::color() const
+{
+    return Chunk::color();
+}
+
+
 int Segment::resize(int amount)
 {
     db<Segment>(TRC) << "Segment::resize(amount=" << amount << ")" << endl;
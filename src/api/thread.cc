@@ -3,6 +3,7 @@
 #include <machine.h>
 #include <system.h>
 #include <process.h>
+#include <utility/log.h>
 
 // This_Thread class attributes
 __BEGIN_UTIL
@@ -14,6 +15,7 @@ __BEGIN_SYS
 volatile unsigned int Thread::_thread_count;
 Scheduler_Timer * Thread::_timer;
 Scheduler<Thread> Thread::_scheduler;
+Per_CPU<Thread *> Thread::_running;
 
 
 void Thread::constructor_prologue(unsigned int stack_size)
@@ -23,7 +25,10 @@ void Thread::constructor_prologue(unsigned int stack_size)
     _thread_count++;
     _scheduler.insert(this);
 
-    _stack = new (SYSTEM) char[stack_size];
+    if((_color != WHITE) && !System::colorful())
+        db<Thread>(WRN) << "Thread: colored stacks need Traits<MMU>::colorful and Traits<System>::multiheap, so color " << _color << " was ignored!" << endl;
+
+    _stack = new (_color) char[stack_size];
 }
 
 
@@ -43,7 +48,7 @@ void Thread::constructor_epilogue(Log_Addr entry, unsigned int stack_size)
         _scheduler.suspend(this);
 
     if(preemptive && (_state == READY) && (_link.rank() != IDLE))
-        reschedule();
+        reschedule(cpu(this));
 
     unlock();
 }
@@ -193,7 +198,7 @@ void Thread::resume()
         _scheduler.resume(this);
 
         if(preemptive)
-            reschedule();
+            reschedule(cpu(this));
     } else
         db<Thread>(WRN) << "Resume called for unsuspended object!" << endl;
 
@@ -275,7 +280,7 @@ void Thread::wakeup(Queue * q)
         _scheduler.resume(t);
 
         if(preemptive)
-            reschedule();
+            reschedule(cpu(t));
     }
 }
 
@@ -287,15 +292,23 @@ void Thread::wakeup_all(Queue * q)
     assert(locked()); // locking handled by caller
 
     if(!q->empty()) {
+        unsigned long cpus = 0;
         while(!q->empty()) {
             Thread * t = q->remove()->object();
             t->_state = READY;
             t->_waiting = 0;
             _scheduler.resume(t);
+            cpus |= 1UL << cpu(t);
         }
 
-        if(preemptive)
-            reschedule();
+        // Other CPUs are told first, since rescheduling this one might switch threads
+        if(preemptive) {
+            for(unsigned int i = 0; i < Traits<Build>::CPUS; i++)
+                if((i != CPU::id()) && (cpus & (1UL << i)))
+                    reschedule(i);
+            if(cpus & (1UL << CPU::id()))
+                reschedule();
+        }
     }
 }
 
@@ -314,6 +327,52 @@ void Thread::reschedule()
 }
 
 
+unsigned int Thread::cpu(Thread * t)
+{
+    if(Criterion::QUEUES > 1)
+        return t->criterion().queue();
+
+    unsigned int cpu = CPU::id();
+    if(Traits<Build>::CPUS > 1) {
+        int lowest = running()->_link.rank();
+        for(unsigned int i = 0; i < Traits<Build>::CPUS; i++) {
+            Thread * r = _running[i];
+            if((i != CPU::id()) && r && (int(r->_link.rank()) > lowest)) {
+                cpu = i;
+                lowest = r->_link.rank();
+            }
+        }
+        if((cpu != CPU::id()) && (int(t->_link.rank()) >= lowest))
+            cpu = CPU::id(); // nobody to preempt elsewhere
+    }
+
+    return cpu;
+}
+
+
+// Rescheduling another CPU takes an IPI, upon which it reschedules itself (see rescheduler()). Where the IC can't send
+// IPIs (e.g. the PC's i8259A), the other CPU only picks the thread up at its next quantum
+void Thread::reschedule(unsigned int cpu)
+{
+    assert(locked()); // locking handled by caller
+
+    if((Traits<Build>::CPUS == 1) || (cpu == CPU::id()))
+        reschedule();
+    else {
+        db<Thread>(TRC) << "Thread::reschedule(cpu=" << cpu << ")" << endl;
+        IC::ipi(cpu, IC::INT_RESCHEDULER);
+    }
+}
+
+
+void Thread::rescheduler(IC::Interrupt_Id i)
+{
+    lock();
+    reschedule();
+    unlock();
+}
+
+
 void Thread::time_slicer(IC::Interrupt_Id i)
 {
     lock();
@@ -322,6 +381,23 @@ void Thread::time_slicer(IC::Interrupt_Id i)
 }
 
 
+// An idle CPU takes a ready thread from a busy one, for criteria with a queue per CPU (see Scheduling_Queue<T, WSRR>)
+bool Thread::steal()
+{
+    lock();
+
+    Thread * t = _scheduler.steal();
+    if(t) {
+        db<Thread>(TRC) << "Thread::steal() => " << t << " (to CPU " << CPU::id() << ")" << endl;
+        reschedule();
+    }
+
+    unlock();
+
+    return t;
+}
+
+
 void Thread::dispatch(Thread * prev, Thread * next, bool charge)
 {
     // "next" is not in the scheduler's queue anymore. It's already "chosen"
@@ -336,6 +412,12 @@ void Thread::dispatch(Thread * prev, Thread * next, bool charge)
             prev->_state = READY;
         next->_state = RUNNING;
 
+        if(Criterion::collecting)
+            prev->criterion().collect();
+
+        if(Traits<Build>::CPUS > 1)
+            *_running = next;
+
         db<Thread>(TRC) << "Thread::dispatch(prev=" << prev << ",next=" << next << ")" << endl;
         if(Traits<Thread>::debugged && Traits<Debug>::info) {
             CPU::Context tmp;
@@ -363,6 +445,15 @@ int Thread::idle()
             db<Thread>(TRC) << "Thread::idle(this=" << running() << ")" << endl;
 
         CPU::int_enable();
+
+        // Buffered output is written out with interrupts on, so it's only done when nothing else wants the CPU
+        if(Traits<Debug>::buffered)
+            Log::drain();
+
+        // Nothing to halt for if another CPU had something to spare
+        if(Criterion::migrating && steal())
+            continue;
+
         CPU::halt();
     }
 
@@ -370,9 +461,13 @@ int Thread::idle()
     db<Thread>(WRN) << "The last thread has exited!" << endl;
     if(reboot) {
         db<Thread>(WRN) << "Rebooting the machine ..." << endl;
+        if(Traits<Debug>::buffered)
+            Log::drain(true);
         Machine::reboot();
     } else {
         db<Thread>(WRN) << "Halting the machine ..." << endl;
+        if(Traits<Debug>::buffered)
+            Log::drain(true);
         CPU::halt();
     }
 
@@ -35,6 +35,12 @@ void Thread::init()
     if(Criterion::timed)
         _timer = new (SYSTEM) Scheduler_Timer(QUANTUM, time_slicer);
 
+    // Threads made ready by other CPUs come along with an IPI (see reschedule(cpu))
+    if(Traits<Build>::CPUS > 1) {
+        IC::int_vector(IC::INT_RESCHEDULER, rescheduler);
+        IC::enable(IC::INT_RESCHEDULER);
+    }
+
     // No more interrupts until we reach init_end
     CPU::int_disable();
 
@@ -0,0 +1,175 @@
+// EPOS ARMv7 Memory Primitives Implementation
+// Strong definitions that replace the weak, word-by-word ones in utility/string.cc
+
+#include <architecture/cpu.h>
+#include <utility/string.h>
+
+__BEGIN_SYS
+
+// Scalar paths: 32 bytes per iteration with LDM/STM of eight registers (valid both in ARM and in Thumb-2, so it also
+// serves Cortex-M). R7 and R11 are left alone because they might be holding the frame pointer. A source misaligned
+// with respect to the destination is read in aligned words and shifted into place
+template<bool simd>
+class ARMv7_Memory
+{
+protected:
+    typedef unsigned long Word;
+
+    static const unsigned long W = sizeof(Word);
+
+public:
+    static void copy(char * d, const char * s, size_t n) {
+        if(n >= 4 * W) {
+            for(; reinterpret_cast<Word>(d) & (W - 1); n--)
+                *d++ = *s++;
+
+            unsigned long k = reinterpret_cast<Word>(s) & (W - 1);
+            if(!k) {
+                if(n >= 8 * W) {
+                    size_t blocks = n / (8 * W);
+                    n -= blocks * 8 * W;
+                    copy_blocks(d, s, blocks);
+                }
+                Word * dw = reinterpret_cast<Word *>(d);
+                const Word * sw = reinterpret_cast<const Word *>(s);
+                for(; n >= W; n -= W)
+                    *dw++ = *sw++;
+                d = reinterpret_cast<char *>(dw);
+                s = reinterpret_cast<const char *>(sw);
+            } else {
+                Word * dw = reinterpret_cast<Word *>(d);
+                const Word * sw = reinterpret_cast<const Word *>(s - k);
+                unsigned int r = k * 8, l = W * 8 - r;
+                Word w0 = *sw++;
+                for(; n >= 4 * W; n -= 4 * W, dw += 4, sw += 4) {
+                    Word w1 = sw[0], w2 = sw[1], w3 = sw[2], w4 = sw[3];
+                    dw[0] = (w0 >> r) | (w1 << l);
+                    dw[1] = (w1 >> r) | (w2 << l);
+                    dw[2] = (w2 >> r) | (w3 << l);
+                    dw[3] = (w3 >> r) | (w4 << l);
+                    w0 = w4;
+                }
+                for(; n >= W; n -= W) {
+                    Word w1 = *sw++;
+                    *dw++ = (w0 >> r) | (w1 << l);
+                    w0 = w1;
+                }
+                d = reinterpret_cast<char *>(dw);
+                s = reinterpret_cast<const char *>(sw) - W + k;
+            }
+        }
+
+        while(n--)
+            *d++ = *s++;
+    }
+
+    static void set(char * d, int c, size_t n) {
+        if(n >= 4 * W) {
+            for(; reinterpret_cast<Word>(d) & (W - 1); n--)
+                *d++ = c;
+
+            Word w = static_cast<unsigned char>(c) * 0x01010101UL;
+            Word * dw = reinterpret_cast<Word *>(d);
+            for(; n >= 8 * W; n -= 8 * W, dw += 8) {
+                dw[0] = w; dw[1] = w; dw[2] = w; dw[3] = w; dw[4] = w; dw[5] = w; dw[6] = w; dw[7] = w;
+            }
+            for(; n >= W; n -= W)
+                *dw++ = w;
+            d = reinterpret_cast<char *>(dw);
+        }
+
+        while(n--)
+            *d++ = c;
+    }
+
+    static int compare(const unsigned char * s1, const unsigned char * s2, size_t n) {
+        if((n >= 4 * W) && !((reinterpret_cast<Word>(s1) | reinterpret_cast<Word>(s2)) & (W - 1))) {
+            const Word * a1 = reinterpret_cast<const Word *>(s1);
+            const Word * a2 = reinterpret_cast<const Word *>(s2);
+            for(; n >= 4 * W; n -= 4 * W, a1 += 4, a2 += 4)
+                if((a1[0] ^ a2[0]) | (a1[1] ^ a2[1]) | (a1[2] ^ a2[2]) | (a1[3] ^ a2[3]))
+                    break;
+            for(; (n >= W) && (*a1 == *a2); n -= W, a1++, a2++);
+            s1 = reinterpret_cast<const unsigned char *>(a1);
+            s2 = reinterpret_cast<const unsigned char *>(a2);
+        }
+
+        for(; n; n--, s1++, s2++)
+            if(*s1 != *s2)
+                return *s1 - *s2;
+
+        return 0;
+    }
+
+private:
+    // Both pointers are advanced past the copied blocks
+    static void copy_blocks(char * & d, const char * & s, size_t blocks) {
+        ASM("1:     ldmia   %1!, {r3, r4, r5, r6, r8, r9, r10, r12} \n"
+            "       stmia   %0!, {r3, r4, r5, r6, r8, r9, r10, r12} \n"
+            "       subs    %2, %2, #1                              \n"
+            "       bne     1b                                      \n" : "+r"(d), "+r"(s), "+r"(blocks) : : "r3", "r4", "r5", "r6", "r8", "r9", "r10", "r12", "cc", "memory");
+    }
+};
+
+// SIMD paths (Traits<CPU>::simd): 32-byte blocks moved through four 64-bit NEON registers. VLD1/VST1.8 have no
+// alignment restrictions, but D0-D3 are clobbered, so this is only safe when the FPU context is saved across
+// context switches
+template<>
+class ARMv7_Memory<true>: public ARMv7_Memory<false>
+{
+public:
+    static void copy(char * d, const char * s, size_t n) {
+        if(n >= 8 * W) {
+            size_t blocks = n / (8 * W);
+            n -= blocks * 8 * W;
+            ASM("       .fpu    neon                            \n"
+                "1:     vld1.8  {d0-d3}, [%1]!                  \n"
+                "       vst1.8  {d0-d3}, [%0]!                  \n"
+                "       subs    %2, %2, #1                      \n"
+                "       bne     1b                              \n" : "+r"(d), "+r"(s), "+r"(blocks) : : "d0", "d1", "d2", "d3", "cc", "memory");
+        }
+        ARMv7_Memory<false>::copy(d, s, n);
+    }
+
+    static void set(char * d, int c, size_t n) {
+        if(n >= 8 * W) {
+            size_t blocks = n / (8 * W);
+            n -= blocks * 8 * W;
+            ASM("       .fpu    neon                            \n"
+                "       vdup.8  q0, %2                          \n"
+                "       vmov    q1, q0                          \n"
+                "1:     vst1.8  {d0-d3}, [%0]!                  \n"
+                "       subs    %1, %1, #1                      \n"
+                "       bne     1b                              \n" : "+r"(d), "+r"(blocks) : "r"(c) : "d0", "d1", "d2", "d3", "cc", "memory");
+        }
+        ARMv7_Memory<false>::set(d, c, n);
+    }
+};
+
+__END_SYS
+
+extern "C"
+{
+    __USING_SYS;
+
+    typedef ARMv7_Memory<Traits<CPU>::simd && Traits<FPU>::enabled> Memory;
+
+    void * memcpy(void * d, const void * s, size_t n)
+    {
+        if(n)
+            Memory::copy(reinterpret_cast<char *>(d), reinterpret_cast<const char *>(s), n);
+        return d;
+    }
+
+    void * memset(void * m, int c, size_t n)
+    {
+        if(n)
+            Memory::set(reinterpret_cast<char *>(m), c, n);
+        return m;
+    }
+
+    int memcmp(const void * m1, const void * m2, size_t n)
+    {
+        return Memory::compare(reinterpret_cast<const unsigned char *>(m1), reinterpret_cast<const unsigned char *>(m2), n);
+    }
+}
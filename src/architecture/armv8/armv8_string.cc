@@ -0,0 +1,198 @@
+// EPOS ARMv8 Memory Primitives Implementation
+// Strong definitions that replace the weak, word-by-word ones in utility/string.cc
+
+#include <architecture/cpu.h>
+#include <utility/string.h>
+
+__BEGIN_SYS
+
+// Scalar paths: 64 bytes per iteration with LDP/STP pairs of X registers. Unaligned accesses are not enabled
+// (Traits<CPU>::unaligned_memory_access), so a source misaligned with respect to the destination is read in aligned
+// double words and shifted into place
+template<bool simd>
+class ARMv8_Memory
+{
+protected:
+    typedef unsigned long Word;
+
+    static const unsigned long W = sizeof(Word);
+
+public:
+    static void copy(char * d, const char * s, size_t n) {
+        if(n >= 4 * W) {
+            for(; reinterpret_cast<Word>(d) & (W - 1); n--)
+                *d++ = *s++;
+
+            unsigned long k = reinterpret_cast<Word>(s) & (W - 1);
+            if(!k) {
+                if(n >= 8 * W) {
+                    size_t blocks = n / (8 * W);
+                    n -= blocks * 8 * W;
+                    copy_blocks(d, s, blocks);
+                }
+                Word * dw = reinterpret_cast<Word *>(d);
+                const Word * sw = reinterpret_cast<const Word *>(s);
+                for(; n >= W; n -= W)
+                    *dw++ = *sw++;
+                d = reinterpret_cast<char *>(dw);
+                s = reinterpret_cast<const char *>(sw);
+            } else {
+                Word * dw = reinterpret_cast<Word *>(d);
+                const Word * sw = reinterpret_cast<const Word *>(s - k);
+                unsigned int r = k * 8, l = W * 8 - r;
+                Word w0 = *sw++;
+                for(; n >= 4 * W; n -= 4 * W, dw += 4, sw += 4) {
+                    Word w1 = sw[0], w2 = sw[1], w3 = sw[2], w4 = sw[3];
+                    dw[0] = (w0 >> r) | (w1 << l);
+                    dw[1] = (w1 >> r) | (w2 << l);
+                    dw[2] = (w2 >> r) | (w3 << l);
+                    dw[3] = (w3 >> r) | (w4 << l);
+                    w0 = w4;
+                }
+                for(; n >= W; n -= W) {
+                    Word w1 = *sw++;
+                    *dw++ = (w0 >> r) | (w1 << l);
+                    w0 = w1;
+                }
+                d = reinterpret_cast<char *>(dw);
+                s = reinterpret_cast<const char *>(sw) - W + k;
+            }
+        }
+
+        while(n--)
+            *d++ = *s++;
+    }
+
+    static void set(char * d, int c, size_t n) {
+        if(n >= 4 * W) {
+            for(; reinterpret_cast<Word>(d) & (W - 1); n--)
+                *d++ = c;
+
+            Word w = static_cast<unsigned char>(c) * 0x0101010101010101UL;
+            if(n >= 8 * W) {
+                size_t blocks = n / (8 * W);
+                n -= blocks * 8 * W;
+                set_blocks(d, w, blocks);
+            }
+            Word * dw = reinterpret_cast<Word *>(d);
+            for(; n >= W; n -= W)
+                *dw++ = w;
+            d = reinterpret_cast<char *>(dw);
+        }
+
+        while(n--)
+            *d++ = c;
+    }
+
+    static int compare(const unsigned char * s1, const unsigned char * s2, size_t n) {
+        if((n >= 4 * W) && !((reinterpret_cast<Word>(s1) | reinterpret_cast<Word>(s2)) & (W - 1))) {
+            const Word * a1 = reinterpret_cast<const Word *>(s1);
+            const Word * a2 = reinterpret_cast<const Word *>(s2);
+            for(; n >= 4 * W; n -= 4 * W, a1 += 4, a2 += 4)
+                if((a1[0] ^ a2[0]) | (a1[1] ^ a2[1]) | (a1[2] ^ a2[2]) | (a1[3] ^ a2[3]))
+                    break;
+            for(; (n >= W) && (*a1 == *a2); n -= W, a1++, a2++);
+            s1 = reinterpret_cast<const unsigned char *>(a1);
+            s2 = reinterpret_cast<const unsigned char *>(a2);
+        }
+
+        for(; n; n--, s1++, s2++)
+            if(*s1 != *s2)
+                return *s1 - *s2;
+
+        return 0;
+    }
+
+private:
+    // Both pointers are advanced past the copied blocks
+    static void copy_blocks(char * & d, const char * & s, size_t blocks) {
+        ASM("1:     ldp     x2, x3, [%1], #16               \n"
+            "       ldp     x4, x5, [%1], #16               \n"
+            "       ldp     x6, x7, [%1], #16               \n"
+            "       ldp     x8, x9, [%1], #16               \n"
+            "       stp     x2, x3, [%0], #16               \n"
+            "       stp     x4, x5, [%0], #16               \n"
+            "       stp     x6, x7, [%0], #16               \n"
+            "       stp     x8, x9, [%0], #16               \n"
+            "       subs    %2, %2, #1                      \n"
+            "       b.ne    1b                              \n" : "+r"(d), "+r"(s), "+r"(blocks) : : "x2", "x3", "x4", "x5", "x6", "x7", "x8", "x9", "cc", "memory");
+    }
+
+    static void set_blocks(char * & d, Word w, size_t blocks) {
+        ASM("1:     stp     %2, %2, [%0], #16               \n"
+            "       stp     %2, %2, [%0], #16               \n"
+            "       stp     %2, %2, [%0], #16               \n"
+            "       stp     %2, %2, [%0], #16               \n"
+            "       subs    %1, %1, #1                      \n"
+            "       b.ne    1b                              \n" : "+r"(d), "+r"(blocks) : "r"(w) : "cc", "memory");
+    }
+};
+
+// SIMD paths (Traits<CPU>::simd): 64-byte blocks moved through four 128-bit Q registers from 16-byte aligned
+// addresses. Since V0-V3 are clobbered, this is only safe when the FPU context is saved across context switches
+template<>
+class ARMv8_Memory<true>: public ARMv8_Memory<false>
+{
+private:
+    static const unsigned long Q = 16;
+
+public:
+    static void copy(char * d, const char * s, size_t n) {
+        if((n >= 10 * W) && !((reinterpret_cast<Word>(d) ^ reinterpret_cast<Word>(s)) & (Q - 1))) {
+            for(; reinterpret_cast<Word>(d) & (Q - 1); n--)
+                *d++ = *s++;
+            size_t blocks = n / (8 * W);
+            n -= blocks * 8 * W;
+            ASM("1:     ldp     q0, q1, [%1], #32               \n"
+                "       ldp     q2, q3, [%1], #32               \n"
+                "       stp     q0, q1, [%0], #32               \n"
+                "       stp     q2, q3, [%0], #32               \n"
+                "       subs    %2, %2, #1                      \n"
+                "       b.ne    1b                              \n" : "+r"(d), "+r"(s), "+r"(blocks) : : "v0", "v1", "v2", "v3", "cc", "memory");
+        }
+        ARMv8_Memory<false>::copy(d, s, n);
+    }
+
+    static void set(char * d, int c, size_t n) {
+        if(n >= 10 * W) {
+            for(; reinterpret_cast<Word>(d) & (Q - 1); n--)
+                *d++ = c;
+            size_t blocks = n / (8 * W);
+            n -= blocks * 8 * W;
+            ASM("       dup     v0.16b, %w2                     \n"
+                "1:     stp     q0, q0, [%0], #32               \n"
+                "       stp     q0, q0, [%0], #32               \n"
+                "       subs    %1, %1, #1                      \n"
+                "       b.ne    1b                              \n" : "+r"(d), "+r"(blocks) : "r"(c) : "v0", "cc", "memory");
+        }
+        ARMv8_Memory<false>::set(d, c, n);
+    }
+};
+
+__END_SYS
+
+extern "C"
+{
+    __USING_SYS;
+
+    typedef ARMv8_Memory<Traits<CPU>::simd && Traits<FPU>::enabled> Memory;
+
+    void * memcpy(void * d, const void * s, size_t n)
+    {
+        if(n)
+            Memory::copy(reinterpret_cast<char *>(d), reinterpret_cast<const char *>(s), n);
+        return d;
+    }
+
+    void * memset(void * m, int c, size_t n)
+    {
+        if(n)
+            Memory::set(reinterpret_cast<char *>(m), c, n);
+        return m;
+    }
+
+    int memcmp(const void * m1, const void * m2, size_t n)
+    {
+        return Memory::compare(reinterpret_cast<const unsigned char *>(m1), reinterpret_cast<const unsigned char *>(m2), n);
+    }
+}
@@ -36,7 +36,7 @@ void MMU::init()
         // Insert a bulk of memory large enough to contain the System's heap into _free[WHITE] lists
         int size = Traits<System>::HEAP_SIZE;
         if((f1t - f1b) > size) {
-            white_free(f1b, pages(f1b + size));
+            white_free(f1b, pages(size));
             f1b += size;
             size = 0;
         } else {
@@ -46,7 +46,7 @@ void MMU::init()
         }
         if(size > 0) {
             if((f2t - f2b) > size) {
-                white_free(f2b, pages(f2b + size));
+                white_free(f2b, pages(size));
                 f2b += size;
                 size = 0;
             } else {
@@ -57,7 +57,7 @@ void MMU::init()
         }
         if(size > 0) {
             if((f3t - f3b) > size) {
-                white_free(f3b, pages(f3b + size));
+                white_free(f3b, pages(size));
                 f3b += size;
                 size = 0;
             } else {
@@ -66,7 +66,7 @@ void MMU::init()
                 f3b = f3t = 0;
             }
         }
-        if((size > 0) || (_free[WHITE].grouped_size() * MMU::PAGE_SIZE < Traits<System>::HEAP_SIZE))
+        if((size > 0) || (free_list(WHITE).grouped_size() * MMU::PAGE_SIZE < Traits<System>::HEAP_SIZE))
             db<Init, MMU>(ERR) << "MMU::int: System's heap size (Traits<System>::HEAP_SIZE=" << Traits<System>::HEAP_SIZE << ") is larger than memory!" << endl;
 
         // Insert the remaining free memory into the _free[color] lists
@@ -94,6 +94,10 @@ void MMU::init()
         free(si->pmm.free3_base, pages(si->pmm.free3_top - si->pmm.free3_base));
     }
 
+    // Enable 4 MB pages for chunks that can use them (see Chunk::large())
+    if(superpages)
+        CPU::cr4(CPU::cr4() | CPU::CR4_PSE);
+
     // Remember the master page directory (created during SETUP)
     _master = current();
     db<Init, MMU>(INF) << "MMU::master page directory=" << _master << endl;
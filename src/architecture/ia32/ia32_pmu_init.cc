@@ -16,7 +16,7 @@ void PMU::init()
     }
 
     // Enable rdpmc for any protection level
-    CPU::cr4((CPU::cr4() | CPU::CR4_PSE));
+    CPU::cr4((CPU::cr4() | CPU::CR4_PCE));
 
     if(APIC::id() == 0) {
     	Reg32 eax, ebx, ecx = 0, edx;
@@ -10,6 +10,9 @@ void CPU::init()
 {
     db<Init, CPU>(TRC) << "CPU::init()" << endl;
 
+    if(Traits<CPU>::vector)
+        mstatuss(VS_INIT);
+
     if(Traits<MMU>::enabled)
         MMU::init();
     else
@@ -0,0 +1,13 @@
+// EPOS RISC-V 64 MMU Mediator Implementation
+
+#include <architecture/rv64/rv64_mmu.h>
+
+__BEGIN_SYS
+
+// Class attributes
+Sv39_MMU::List Sv39_MMU::_free[colorful * COLORS + 1];
+Sv39_MMU::Page_Directory * Sv39_MMU::_master;
+Bitmap<Sv39_MMU::ASIDS> Sv39_MMU::_asids;
+Sv39_MMU::ASID Sv39_MMU::_asids_max;
+
+__END_SYS
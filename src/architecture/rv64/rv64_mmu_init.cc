@@ -0,0 +1,58 @@
+// EPOS RISC-V 64 MMU Mediator Initialization
+
+#include <architecture/mmu.h>
+#include <system.h>
+
+extern "C" char _end;
+
+__BEGIN_SYS
+
+void Sv39_MMU::init()
+{
+    db<Init, MMU>(TRC) << "MMU::init()" << endl;
+
+    db<Init, MMU>(INF) << "MMU::memory={base=" << reinterpret_cast<void *>(RAM_BASE) << ",size="
+                       << (RAM_TOP + 1 - RAM_BASE) / 1024 << "KB}" << endl;
+
+    // There is no paging at SETUP on RISC-V, so everything after the image (i.e. after &_end) up to FREE_TOP is free
+    Phy_Addr base = align_page(Log_Addr(&_end));
+    unsigned long frames = pages(Memory_Map::FREE_TOP - base);
+
+    // With colors, a bulk large enough for the system's heap (and its page tables) stays uncolored
+    if(colorful) {
+        unsigned long white = pages(Traits<System>::HEAP_SIZE) + page_tables(pages(Traits<System>::HEAP_SIZE));
+        if(white > frames) {
+            db<Init, MMU>(ERR) << "MMU::init: System's heap size (Traits<System>::HEAP_SIZE=" << Traits<System>::HEAP_SIZE << ") is larger than memory!" << endl;
+            white = frames;
+        }
+        List::Element * e = new (phy2log(base)) List::Element(base, white);
+        List::Element * m1, * m2;
+        free_list(WHITE).insert_merging(e, &m1, &m2);
+        base += white * sizeof(Frame);
+        frames -= white;
+    }
+
+    // Insert the remaining free memory into the _free[color] lists (or all of it into the _free[WHITE] one)
+    free(base, frames);
+
+    // Build the master page directory, which identity-maps the I/O space and the physical memory with 1 GB global
+    // pages, so page tables can be reached through the same addresses whether translation is enabled or not
+    // Address_Spaces share these root entries and get their own level 1 tables for the application's region
+    _master = calloc(1, WHITE);
+    for(unsigned long i = attacher(MIO_BASE); i <= attacher(MIO_TOP); i++)
+        _master->log()[i] = phy2pte(i << ATTACHER_SHIFT, Page_Flags::MIO);
+    for(unsigned long i = attacher(RAM_BASE); i <= attacher(RAM_TOP); i++)
+        _master->log()[i] = phy2pte(i << ATTACHER_SHIFT, Page_Flags::KRN);
+
+    // Probe how many ASID bits are implemented (writes to unimplemented bits are ignored)
+    CPU::satp(SV39 | ASID_MASK | (Phy_Addr(_master) >> PAGE_SHIFT));
+    ASID implemented = ((CPU::satp() & ASID_MASK) >> ASID_SHIFT) + 1;
+    _asids_max = (implemented < ASIDS) ? implemented : ASIDS;
+    _asids.set(0);
+
+    // Activate the master page directory with ASID 0
+    pd(_master);
+    db<Init, MMU>(INF) << "MMU::master page directory=" << _master << ",ASIDs=" << _asids_max << endl;
+}
+
+__END_SYS
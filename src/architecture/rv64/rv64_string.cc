@@ -0,0 +1,162 @@
+// EPOS RISC-V 64 Memory Primitives Implementation
+// Strong definitions that replace the weak, word-by-word ones in utility/string.cc
+
+#include <architecture/cpu.h>
+#include <utility/string.h>
+
+__BEGIN_SYS
+
+// Scalar paths: unrolled 64-bit loads and stores. RV64 has no (fast) unaligned access, so a source misaligned with
+// respect to the destination is read in aligned words and shifted into place (little endian)
+template<bool vector>
+class RV64_Memory
+{
+private:
+    typedef unsigned long Word;
+
+    static const unsigned long W = sizeof(Word);
+
+public:
+    static void copy(char * d, const char * s, size_t n) {
+        if(n >= 4 * W) {
+            for(; reinterpret_cast<Word>(d) & (W - 1); n--)
+                *d++ = *s++;
+
+            Word * dw = reinterpret_cast<Word *>(d);
+            unsigned long k = reinterpret_cast<Word>(s) & (W - 1);
+            if(!k) {
+                const Word * sw = reinterpret_cast<const Word *>(s);
+                for(; n >= 8 * W; n -= 8 * W, dw += 8, sw += 8) {
+                    Word w0 = sw[0], w1 = sw[1], w2 = sw[2], w3 = sw[3], w4 = sw[4], w5 = sw[5], w6 = sw[6], w7 = sw[7];
+                    dw[0] = w0; dw[1] = w1; dw[2] = w2; dw[3] = w3; dw[4] = w4; dw[5] = w5; dw[6] = w6; dw[7] = w7;
+                }
+                for(; n >= W; n -= W)
+                    *dw++ = *sw++;
+                s = reinterpret_cast<const char *>(sw);
+            } else {
+                const Word * sw = reinterpret_cast<const Word *>(s - k);
+                unsigned int r = k * 8, l = W * 8 - r;
+                Word w0 = *sw++;
+                for(; n >= 4 * W; n -= 4 * W, dw += 4, sw += 4) {
+                    Word w1 = sw[0], w2 = sw[1], w3 = sw[2], w4 = sw[3];
+                    dw[0] = (w0 >> r) | (w1 << l);
+                    dw[1] = (w1 >> r) | (w2 << l);
+                    dw[2] = (w2 >> r) | (w3 << l);
+                    dw[3] = (w3 >> r) | (w4 << l);
+                    w0 = w4;
+                }
+                for(; n >= W; n -= W) {
+                    Word w1 = *sw++;
+                    *dw++ = (w0 >> r) | (w1 << l);
+                    w0 = w1;
+                }
+                s = reinterpret_cast<const char *>(sw) - W + k;
+            }
+            d = reinterpret_cast<char *>(dw);
+        }
+
+        while(n--)
+            *d++ = *s++;
+    }
+
+    static void set(char * d, int c, size_t n) {
+        if(n >= 4 * W) {
+            for(; reinterpret_cast<Word>(d) & (W - 1); n--)
+                *d++ = c;
+
+            Word w = static_cast<unsigned char>(c) * 0x0101010101010101UL;
+            Word * dw = reinterpret_cast<Word *>(d);
+            for(; n >= 8 * W; n -= 8 * W, dw += 8) {
+                dw[0] = w; dw[1] = w; dw[2] = w; dw[3] = w; dw[4] = w; dw[5] = w; dw[6] = w; dw[7] = w;
+            }
+            for(; n >= W; n -= W)
+                *dw++ = w;
+            d = reinterpret_cast<char *>(dw);
+        }
+
+        while(n--)
+            *d++ = c;
+    }
+
+    static int compare(const unsigned char * s1, const unsigned char * s2, size_t n) {
+        if((n >= 4 * W) && !((reinterpret_cast<Word>(s1) | reinterpret_cast<Word>(s2)) & (W - 1))) {
+            const Word * a1 = reinterpret_cast<const Word *>(s1);
+            const Word * a2 = reinterpret_cast<const Word *>(s2);
+            for(; n >= 4 * W; n -= 4 * W, a1 += 4, a2 += 4)
+                if((a1[0] ^ a2[0]) | (a1[1] ^ a2[1]) | (a1[2] ^ a2[2]) | (a1[3] ^ a2[3]))
+                    break;
+            for(; (n >= W) && (*a1 == *a2); n -= W, a1++, a2++);
+            s1 = reinterpret_cast<const unsigned char *>(a1);
+            s2 = reinterpret_cast<const unsigned char *>(a2);
+        }
+
+        for(; n; n--, s1++, s2++)
+            if(*s1 != *s2)
+                return *s1 - *s2;
+
+        return 0;
+    }
+};
+
+// Vector paths (Traits<CPU>::vector): strip-mined with the widest register group (e8, m8), so each iteration moves
+// 8 x VLEN bits. The assembler is told about the V extension locally, since the kernel is built for rv64gc
+template<>
+class RV64_Memory<true>: public RV64_Memory<false>
+{
+public:
+    static void copy(char * d, const char * s, size_t n) {
+        size_t vl;
+        ASM("       .option push                            \n"
+            "       .option arch, +v                        \n"
+            "1:     vsetvli     %3, %2, e8, m8, ta, ma      \n"
+            "       vle8.v      v0, (%1)                    \n"
+            "       add         %1, %1, %3                  \n"
+            "       sub         %2, %2, %3                  \n"
+            "       vse8.v      v0, (%0)                    \n"
+            "       add         %0, %0, %3                  \n"
+            "       bnez        %2, 1b                      \n"
+            "       .option pop                             \n" : "+r"(d), "+r"(s), "+r"(n), "=&r"(vl) : : "memory");
+    }
+
+    static void set(char * d, int c, size_t n) {
+        size_t vl;
+        ASM("       .option push                            \n"
+            "       .option arch, +v                        \n"
+            "       vsetvli     %2, zero, e8, m8, ta, ma    \n"
+            "       vmv.v.x     v0, %3                      \n"
+            "1:     vsetvli     %2, %1, e8, m8, ta, ma      \n"
+            "       vse8.v      v0, (%0)                    \n"
+            "       add         %0, %0, %2                  \n"
+            "       sub         %1, %1, %2                  \n"
+            "       bnez        %1, 1b                      \n"
+            "       .option pop                             \n" : "+r"(d), "+r"(n), "=&r"(vl) : "r"(c) : "memory");
+    }
+};
+
+__END_SYS
+
+extern "C"
+{
+    __USING_SYS;
+
+    typedef RV64_Memory<Traits<CPU>::vector> Memory;
+
+    void * memcpy(void * d, const void * s, size_t n)
+    {
+        if(n)
+            Memory::copy(reinterpret_cast<char *>(d), reinterpret_cast<const char *>(s), n);
+        return d;
+    }
+
+    void * memset(void * m, int c, size_t n)
+    {
+        if(n)
+            Memory::set(reinterpret_cast<char *>(m), c, n);
+        return m;
+    }
+
+    int memcmp(const void * m1, const void * m2, size_t n)
+    {
+        return Memory::compare(reinterpret_cast<const unsigned char *>(m1), reinterpret_cast<const unsigned char *>(m2), n);
+    }
+}
@@ -36,6 +36,19 @@ public:
         } else
             System::_heap = new (&System::_preheap[0]) Heap(MMU::alloc(MMU::pages(HEAP_SIZE)), HEAP_SIZE);
 
+        // Each colored heap lives in a segment of a single color (segments don't take color sets)
+        if(System::colored) {
+            db<Init>(INF) << "Initializing system's colored heaps: " << endl;
+            for(unsigned int c = 0; c < System::COLORS; c++) {
+                Segment * segment = new (SYSTEM) Segment(HEAP_SIZE / System::COLORS, Color(c), Segment::Flags::SYS);
+                char * heap = Address_Space(MMU::current()).attach(segment);
+                if(!heap)
+                    db<Init>(ERR) << "Failed to initialize the system's heap for color " << c << "!" << endl;
+                System::_colored_heap[c] = new (SYSTEM) Heap(heap, segment->size());
+            }
+        } else if(Traits<MMU>::colorful)
+            db<Init>(WRN) << "Colored heaps need multiheap and address translation in the kernel (IA32), new (color) will use the system's heap!" << endl;
+
         db<Init>(INF) << "Initializing the machine: " << endl;
         Machine::init();
 
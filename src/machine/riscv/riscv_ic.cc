@@ -39,11 +39,22 @@ void IC::dispatch()
     if((id != INT_SYS_TIMER) || Traits<IC>::hysterically_debugged)
         db<IC>(TRC) << "IC::dispatch(i=" << id << ")" << endl;
 
-    // MIP.MTI is a direct logic on (MTIME == MTIMECMP) and reseting the Timer seems to be the only way to clear it
-    if(id == INT_SYS_TIMER)
-        Timer::reset();
-
-    _int_vector[id](id);
+    // MIP.MSI stays up while the hart's MSIP is set
+    if(id == INT_RESCHEDULER)
+        reg(MSIP + CPU::mhartid() * MSIP_CORE_OFFSET) = 0;
+
+    // MIP.MTI is a direct logic on (MTIME >= MTIMECMP), so it's only cleared when Timer::int_handler() programs the
+    // next deadline
+    // External interrupts are demultiplexed by the PLIC, and all sources pending are handled before returning
+    if(id == INT_EXTERNAL) {
+        for(unsigned int irq; (irq = PLIC::claim()); PLIC::complete(irq)) {
+            Interrupt_Id i = INT_PLIC + irq;
+            if(Traits<IC>::hysterically_debugged)
+                db<IC>(TRC) << "IC::dispatch(plic=" << irq << ")" << endl;
+            _int_vector[i](i);
+        }
+    } else
+        _int_vector[id](id);
 
     if(id >= EXCS)
         CPU::fr(0); // tell CPU::Context::pop(true) not to increment PC since it is automatically incremented for hardware interrupts
@@ -21,6 +21,11 @@ void IC::init()
     // Set all interrupt handlers to int_not()
     for(Interrupt_Id i = EXCS; i < INTS; i++)
         _int_vector[i] = &int_not;
+
+    // Mask all PLIC sources for this hart and let any priority through (sources with priority 0 never interrupt)
+    for(unsigned int irq = 1; irq < PLIC::IRQS; irq++)
+        PLIC::disable(irq);
+    PLIC::threshold(0);
 }
 
 __END_SYS
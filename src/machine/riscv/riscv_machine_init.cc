@@ -13,6 +13,9 @@ void Machine::init()
 
     if(Traits<Timer>::enabled)
         Timer::init();
+
+    if(Traits<UART>::interrupt_driven)
+        UART::init();
 }
 
 __END_SYS
@@ -6,20 +6,51 @@
 __BEGIN_SYS
 
 // Class attributes
-Timer * Timer::_channels[CHANNELS];
+Per_CPU<Timer::Channels> Timer::_channels;
 
 // Class methods
+// Channels that are due get their next deadlines, and MTIMECMP is set to the earliest, before any handler is called,
+// since the scheduler's might not return until the preempted thread runs again (which is also why it goes last).
+// Alarm's events go first, since they are the high-resolution wakeups and the alarm's handlers can take a while.
+// The alarm gets a call for each period elapsed, so its count of ticks doesn't drift if an interrupt is delayed, while
+// the others get a single one.
 void Timer::int_handler(Interrupt_Id i)
 {
-    if(_channels[ALARM] && (--_channels[ALARM]->_current <= 0)) {
-        _channels[ALARM]->_current = _channels[ALARM]->_initial;
-        _channels[ALARM]->_handler(i);
-    }
+    Channels & channels = *_channels;
+    Time_Stamp now = time();
+    unsigned int ticks[CHANNELS] = {};
+
+    for(unsigned int c = 0; c < CHANNELS; c++) {
+        Timer * t = channels[c];
+        if(!t || (t->_deadline > now))
+            continue;
 
-    if(_channels[SCHEDULER] && (--_channels[SCHEDULER]->_current <= 0)) {
-        _channels[SCHEDULER]->_current = _channels[SCHEDULER]->_initial;
-        _channels[SCHEDULER]->_handler(i);
+        if(!t->_retrigger) {
+            ticks[c] = 1;
+            t->_deadline = NEVER;
+        } else if(c == ALARM) {
+            ticks[c] = (now - t->_deadline) / t->_period + 1;
+            t->_deadline += ticks[c] * t->_period;
+        } else {
+            ticks[c] = 1;
+            t->_deadline = now + t->_period;
+        }
     }
+
+    program();
+
+    if(channels[EVENT] && ticks[EVENT])
+        channels[EVENT]->_handler(i);
+
+    if(channels[ALARM])
+        for(; ticks[ALARM]; ticks[ALARM]--)
+            channels[ALARM]->_handler(i);
+
+    if(channels[USER] && ticks[USER])
+        channels[USER]->_handler(i);
+
+    if(channels[SCHEDULER] && ticks[SCHEDULER])
+        channels[SCHEDULER]->_handler(i);
 }
 
 __END_SYS
@@ -0,0 +1,105 @@
+// EPOS RISC-V UART Mediator Implementation
+
+#include <machine/uart.h>
+#include <synchronizer.h>
+
+__BEGIN_SYS
+
+// Class attributes
+UART * UART::_device;
+UART::Ring<UART::TX_BUFFER_SIZE> UART::_tx;
+UART::Ring<UART::RX_BUFFER_SIZE> UART::_rx;
+Semaphore * UART::_rx_data;
+volatile unsigned int UART::_overruns;
+volatile int UART::_lock;
+
+// Methods
+char UART::get_buffered()
+{
+    // Without interrupts (e.g. at a panic), there's no way to sleep, so whatever the handler left in the ring goes first
+    if(CPU::int_disabled()) {
+        bool enabled = lock();
+        bool got = !_rx.empty();
+        char c = got ? _rx.get() : 0;
+        unlock(enabled);
+        return got ? c : get_polled();
+    }
+
+    // The semaphore may count characters already taken above, so a reader that finds the ring empty just waits again
+    for(;;) {
+        _rx_data->p();
+        bool enabled = lock();
+        if(!_rx.empty()) {
+            char c = _rx.get();
+            unlock(enabled);
+            return c;
+        }
+        unlock(enabled);
+    }
+}
+
+void UART::put_buffered(char c)
+{
+    // Without interrupts, nothing would ever drain the ring, so output goes out synchronously (after what's queued)
+    if(CPU::int_disabled()) {
+        drain();
+        put_polled(c);
+        return;
+    }
+
+    bool enabled = lock();
+    if(_tx.empty() && txd_ok())
+        txd(c);
+    else {
+        // A writer only waits when the ring is full, and then for a single character to leave
+        if(_tx.full()) {
+            while(!txd_ok());
+            txd(_tx.get());
+        }
+        _tx.put(c);
+        int_enable(true, true, false, false);
+    }
+    unlock(enabled);
+}
+
+void UART::drain()
+{
+    bool enabled = lock();
+    while(!_tx.empty()) {
+        while(!txd_ok());
+        txd(_tx.get());
+    }
+    int_enable(true, false, false, false);
+    unlock(enabled);
+}
+
+// Class methods
+void UART::int_handler(Interrupt_Id i)
+{
+    unsigned int received = 0;
+
+    bool enabled = lock();
+
+    while(_device->rxd_ok()) {
+        char c = _device->rxd();
+        if(_rx.full())
+            _overruns++;
+        else {
+            _rx.put(c);
+            received++;
+        }
+    }
+
+    // TX watermark: refill the FIFO and stop the interrupt once the ring is empty
+    while(!_tx.empty() && _device->txd_ok())
+        _device->txd(_tx.get());
+    _device->int_enable(true, !_tx.empty(), false, false);
+
+    unlock(enabled);
+
+    // Readers are only woken up after the lock is released, since waking them may reschedule
+    for(; received; received--)
+        _rx_data->v();
+}
+
+__END_SYS
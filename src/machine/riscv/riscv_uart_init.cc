@@ -0,0 +1,25 @@
+// EPOS RISC-V UART Mediator Initialization
+
+#include <machine/uart.h>
+#include <machine/ic.h>
+#include <synchronizer.h>
+#include <system.h>
+
+__BEGIN_SYS
+
+void UART::init()
+{
+    db<Init, UART>(TRC) << "UART::init()" << endl;
+
+    assert(CPU::int_disabled());
+
+    _device = new (SYSTEM) UART;
+    _rx_data = new (SYSTEM) Semaphore(0);
+
+    IC::int_vector(IC::INT_UART0, int_handler);
+
+    _device->int_enable(true, false, false, false);
+    IC::enable(IC::INT_UART0);
+}
+
+__END_SYS
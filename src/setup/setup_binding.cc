@@ -22,5 +22,12 @@ extern "C" {
     void _print(const char * s) { Display::puts(s); }
     void _print_preamble() {}
     void _print_trailler(bool error) { if(error) _panic(); }
+    void _print_raw(const char * s, unsigned int size) {
+        if(Traits<Debug>::binary)
+            Serial_Display::write(s, size);
+        else
+            for(unsigned int i = 0; i < size; i++)
+                Display::putc(s[i]);
+    }
 }
 
@@ -2,6 +2,7 @@
 
 #include <utility/ostream.h>
 #include <utility/heap.h>
+#include <utility/log.h>
 #include <machine.h>
 #include <memory.h>
 #include <process.h>
@@ -21,6 +22,7 @@ System_Info * System::_si = (Memory_Map::SYS_INFO != Memory_Map::NOT_USED) ? rei
 char System::_preheap[];
 Segment * System::_heap_segment;
 Heap * System::_heap;
+Heap * System::_colored_heap[];
 
 __END_SYS
 
@@ -29,14 +31,32 @@ extern "C" {
     __USING_SYS;
 
     // Libc legacy
-    void _panic() { Machine::panic(); }
+    void _panic() {
+        if(Traits<Debug>::buffered)
+            Log::drain(true);
+        Machine::panic();
+    }
     void _exit(int s) { Thread::exit(s); for(;;); }
     void __exit() { _exit(CPU::fr()); }  // must be handled by the Page Fault handler for user-level tasks
     void __cxa_pure_virtual() { db<void>(ERR) << "Pure Virtual method called!" << endl; }
 
     // Utility-related methods that differ from kernel and user space.
     // OStream
-    void _print(const char * s) { Display::puts(s); }
+    void _print(const char * s) {
+        if(Traits<Debug>::buffered)
+            Log::write(s);
+        else
+            Display::puts(s);
+    }
     void _print_preamble() {}
     void _print_trailler(bool error) { if(error) _panic(); }
+
+    // Output that is not text (when Traits<Debug>::binary) goes to the serial line as is
+    void _print_raw(const char * s, unsigned int size) {
+        if(Traits<Debug>::binary)
+            Serial_Display::write(s, size);
+        else
+            for(unsigned int i = 0; i < size; i++)
+                Display::putc(s[i]);
+    }
 }
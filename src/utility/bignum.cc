@@ -5,12 +5,15 @@
 __BEGIN_UTIL
 
 // Class attributes
+
+// 2^128 - 2^97 - 1: secp128r1, used by Diffie-Hellman
 template<>
 const Bignum<16>::_Word Bignum<16>::_mod = {{ 0xff, 0xff, 0xff, 0xff,
                                               0xff, 0xff, 0xff, 0xff,
                                               0xff, 0xff, 0xff, 0xff,
                                               0xfd, 0xff, 0xff, 0xff }};
 
+// 0x100000002000000040000000800000011 (the same for 32 and 64-bit digits)
 template<>
 const Bignum<16>::_Barrett Bignum<16>::_barrett_u = {{ 17, 0, 0, 0,
                                                         8, 0, 0, 0,
@@ -19,7 +22,7 @@ const Bignum<16>::_Barrett Bignum<16>::_barrett_u = {{ 17, 0, 0, 0,
                                                         1, 0, 0, 0}};
 
 
-// 2^(130) - 5: used by Poly1305
+// 2^(130) - 5 (the prime of Poly1305)
 template<>
 const Bignum<17>::_Word Bignum<17>::_mod = {{ 0xfb, 0xff, 0xff, 0xff,
                                               0xff, 0xff, 0xff, 0xff,
@@ -27,6 +30,22 @@ const Bignum<17>::_Word Bignum<17>::_mod = {{ 0xfb, 0xff, 0xff, 0xff,
                                               0xff, 0xff, 0xff, 0xff,
                                               0x03, 0x00, 0x00, 0x00 }};
 
+// Barrett's constant depends on the number of digits: floor(base^(2 * DIGITS) / _mod)
+#ifdef __SIZEOF_INT128__
+
+// 0x4000000000000000000000000000000050000000000000000000000000000000
+template<>
+const Bignum<17>::_Barrett Bignum<17>::_barrett_u = {{ 0x00, 0x00, 0x00, 0x00,
+                                                       0x00, 0x00, 0x00, 0x00,
+                                                       0x00, 0x00, 0x00, 0x00,
+                                                       0x00, 0x00, 0x00, 0x50,
+                                                       0x00, 0x00, 0x00, 0x00,
+                                                       0x00, 0x00, 0x00, 0x00,
+                                                       0x00, 0x00, 0x00, 0x00,
+                                                       0x00, 0x00, 0x00, 0x40 }};
+
+#else
+
 // 0x400000000000000000000000000000005000000000000000
 template<>
 const Bignum<17>::_Barrett Bignum<17>::_barrett_u = {{ 0x00, 0x00, 0x00, 0x00,
@@ -35,4 +54,7 @@ const Bignum<17>::_Barrett Bignum<17>::_barrett_u = {{ 0x00, 0x00, 0x00, 0x00,
                                                        0x00, 0x00, 0x00, 0x00,
                                                        0x00, 0x00, 0x00, 0x00,
                                                        0x00, 0x00, 0x00, 0x40 }};
+
+#endif
+
 __END_UTIL
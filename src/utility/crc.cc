@@ -0,0 +1,132 @@
+// EPOS CRC Utility Implementation
+
+#include <utility/crc.h>
+
+__BEGIN_UTIL
+
+const CRC::CRC16_Table CRC::_crc16;
+const CRC::CRC32_Table CRC::_crc32;
+const CRC::CRC32C_Table CRC::_crc32c;
+
+unsigned short CRC::crc16(const void * data, size_t size, unsigned short crc, Method method)
+{
+    const unsigned char * p = reinterpret_cast<const unsigned char *>(data);
+    const unsigned short (& t)[8][256] = _crc16.t;
+
+    if(method == BITWISE) {
+        for(; size; size--) {
+            crc ^= *p++ << 8;
+            for(unsigned int i = 0; i < 8; i++)
+                crc = (crc & 0x8000) ? (crc << 1) ^ CRC16_POLY : crc << 1;
+        }
+        return crc;
+    }
+
+    // MSB first, so bytes are consumed in order and the CRC is folded into the first two of each slice
+    if(method >= SLICING_8)
+        for(; size >= 8; size -= 8, p += 8)
+            crc = t[7][p[0] ^ (crc >> 8)] ^ t[6][p[1] ^ (crc & 0xff)] ^ t[5][p[2]] ^ t[4][p[3]]
+                ^ t[3][p[4]] ^ t[2][p[5]] ^ t[1][p[6]] ^ t[0][p[7]];
+    if(method >= SLICING_4)
+        for(; size >= 4; size -= 4, p += 4)
+            crc = t[3][p[0] ^ (crc >> 8)] ^ t[2][p[1] ^ (crc & 0xff)] ^ t[1][p[2]] ^ t[0][p[3]];
+    for(; size; size--)
+        crc = (crc << 8) ^ t[0][(crc >> 8) ^ *p++];
+
+    return crc;
+}
+
+unsigned int CRC::crc32(const void * data, size_t size, unsigned int crc, Method method)
+{
+    if(hardware && (method == HARDWARE))
+        return hw_crc32(reinterpret_cast<const unsigned char *>(data), size, crc);
+    else
+        return reflected(_crc32.t, CRC32_POLY, reinterpret_cast<const unsigned char *>(data), size, crc, method);
+}
+
+unsigned int CRC::crc32c(const void * data, size_t size, unsigned int crc, Method method)
+{
+    if(hardware && (method == HARDWARE))
+        return hw_crc32c(reinterpret_cast<const unsigned char *>(data), size, crc);
+    else
+        return reflected(_crc32c.t, CRC32C_POLY, reinterpret_cast<const unsigned char *>(data), size, crc, method);
+}
+
+// LSB first: slices are read as little-endian words (as on all supported architectures) from aligned addresses
+unsigned int CRC::reflected(const unsigned int (& t)[8][256], unsigned int poly, const unsigned char * p, size_t size, unsigned int crc, Method method)
+{
+    crc = ~crc;
+
+    if(method == BITWISE) {
+        for(; size; size--) {
+            crc ^= *p++;
+            for(unsigned int i = 0; i < 8; i++)
+                crc = (crc & 1) ? (crc >> 1) ^ poly : crc >> 1;
+        }
+        return ~crc;
+    }
+
+    if(method >= SLICING_4) {
+        for(; size && (reinterpret_cast<unsigned long>(p) & 3); size--)
+            crc = (crc >> 8) ^ t[0][(crc ^ *p++) & 0xff];
+
+        if(method >= SLICING_8)
+            for(; size >= 8; size -= 8, p += 8) {
+                unsigned int lo = crc ^ *reinterpret_cast<const unsigned int *>(p);
+                unsigned int hi = *reinterpret_cast<const unsigned int *>(p + 4);
+                crc = t[7][lo & 0xff] ^ t[6][(lo >> 8) & 0xff] ^ t[5][(lo >> 16) & 0xff] ^ t[4][lo >> 24]
+                    ^ t[3][hi & 0xff] ^ t[2][(hi >> 8) & 0xff] ^ t[1][(hi >> 16) & 0xff] ^ t[0][hi >> 24];
+            }
+
+        for(; size >= 4; size -= 4, p += 4) {
+            unsigned int w = crc ^ *reinterpret_cast<const unsigned int *>(p);
+            crc = t[3][w & 0xff] ^ t[2][(w >> 8) & 0xff] ^ t[1][(w >> 16) & 0xff] ^ t[0][w >> 24];
+        }
+    }
+
+    for(; size; size--)
+        crc = (crc >> 8) ^ t[0][(crc ^ *p++) & 0xff];
+
+    return ~crc;
+}
+
+#ifdef __armv8__
+
+// CRC32[C]X folds 8 bytes per instruction, CRC32[C]B takes care of the misaligned head and of the tail
+template<bool castagnoli>
+static inline unsigned int armv8_crc32(const unsigned char * p, size_t size, unsigned int crc)
+{
+    crc = ~crc;
+
+    for(; size && (reinterpret_cast<unsigned long>(p) & 7); size--, p++)
+        if(castagnoli)
+            ASM(".arch_extension crc \n crc32cb %w0, %w0, %w1" : "+r"(crc) : "r"(static_cast<unsigned int>(*p)));
+        else
+            ASM(".arch_extension crc \n crc32b %w0, %w0, %w1" : "+r"(crc) : "r"(static_cast<unsigned int>(*p)));
+
+    for(; size >= 8; size -= 8, p += 8)
+        if(castagnoli)
+            ASM(".arch_extension crc \n crc32cx %w0, %w0, %x1" : "+r"(crc) : "r"(*reinterpret_cast<const unsigned long *>(p)));
+        else
+            ASM(".arch_extension crc \n crc32x %w0, %w0, %x1" : "+r"(crc) : "r"(*reinterpret_cast<const unsigned long *>(p)));
+
+    for(; size; size--, p++)
+        if(castagnoli)
+            ASM(".arch_extension crc \n crc32cb %w0, %w0, %w1" : "+r"(crc) : "r"(static_cast<unsigned int>(*p)));
+        else
+            ASM(".arch_extension crc \n crc32b %w0, %w0, %w1" : "+r"(crc) : "r"(static_cast<unsigned int>(*p)));
+
+    return ~crc;
+}
+
+unsigned int CRC::hw_crc32(const unsigned char * p, size_t size, unsigned int crc) { return armv8_crc32<false>(p, size, crc); }
+unsigned int CRC::hw_crc32c(const unsigned char * p, size_t size, unsigned int crc) { return armv8_crc32<true>(p, size, crc); }
+
+#else
+
+unsigned int CRC::hw_crc32(const unsigned char * p, size_t size, unsigned int crc) { return reflected(_crc32.t, CRC32_POLY, p, size, crc, SLICING_8); }
+unsigned int CRC::hw_crc32c(const unsigned char * p, size_t size, unsigned int crc) { return reflected(_crc32c.t, CRC32C_POLY, p, size, crc, SLICING_8); }
+
+#endif
+
+__END_UTIL
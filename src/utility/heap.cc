@@ -7,6 +7,23 @@ extern "C" { void _panic(); }
 __BEGIN_UTIL
 
 // Methods
+unsigned long Heap::largest_free() const
+{
+    unsigned long largest = 0;
+    for(Element * e = const_cast<Heap *>(this)->head(); e; e = e->next())
+        if(e->size() > largest)
+            largest = e->size();
+    return largest;
+}
+
+
+OStream & operator<<(OStream & os, const Heap & h)
+{
+    os << "{free=" << h.grouped_size() << ",blocks=" << h.free_blocks() << ",largest=" << h.largest_free() << ",stats=" << h.statistics() << "}";
+    return os;
+}
+
+
 void Heap::out_of_memory(unsigned long bytes)
 {
     db<Heaps, System>(ERR) << "Heap::alloc(this=" << this << "): out of memory while allocating " << bytes << " bytes!" << endl;
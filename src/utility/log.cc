@@ -0,0 +1,17 @@
+#include <utility/log.h>
+
+__BEGIN_UTIL
+
+Per_CPU<Log::Ring> Log::_rings;
+volatile int Log::_draining;
+
+
+void Binary_Debug::commit(const unsigned char * record, unsigned int size)
+{
+    if(Traits<Debug>::buffered)
+        Log::write(record, size);
+    else
+        _print_raw(reinterpret_cast<const char *>(record), size);
+}
+
+__END_UTIL
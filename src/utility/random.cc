@@ -2,6 +2,6 @@
 
 __BEGIN_UTIL
 
-int Random::_seed;
+Per_CPU<Random::Generator> Random::_generators;
 
 __END_UTIL
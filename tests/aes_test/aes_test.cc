@@ -0,0 +1,115 @@
+// EPOS AES Utility Test Program (known-answer tests for ECB, CTR and GCM, and throughput)
+
+#include <architecture.h>
+#include <utility/aes.h>
+#include <utility/gcm.h>
+
+using namespace EPOS;
+
+typedef SWAES<16> AES;
+
+const unsigned int SIZE = 4 * 1024;
+const unsigned int ROUNDS = 8;
+
+OStream cout;
+unsigned char buffer[SIZE];
+
+// FIPS-197 Appendix C.1
+const unsigned char fips_key[16] = { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f };
+const unsigned char fips_plain[16] = { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff };
+const unsigned char fips_cipher[16] = { 0x69, 0xc4, 0xe0, 0xd8, 0x6a, 0x7b, 0x04, 0x30, 0xd8, 0xcd, 0xb7, 0x80, 0x70, 0xb4, 0xc5, 0x5a };
+
+// SP 800-38A F.5.1 (first block)
+const unsigned char ctr_key[16] = { 0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c };
+const unsigned char ctr_counter[16] = { 0xf0, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa, 0xfb, 0xfc, 0xfd, 0xfe, 0xff };
+const unsigned char ctr_plain[16] = { 0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96, 0xe9, 0x3d, 0x7e, 0x11, 0x73, 0x93, 0x17, 0x2a };
+const unsigned char ctr_cipher[16] = { 0x87, 0x4d, 0x61, 0x91, 0xb6, 0x20, 0xe3, 0x26, 0x1b, 0xef, 0x68, 0x64, 0x99, 0x0d, 0xb6, 0xce };
+
+// GCM specification (McGrew and Viega), test case 2
+const unsigned char gcm_key[16] = { 0 };
+const unsigned char gcm_iv[12] = { 0 };
+const unsigned char gcm_cipher[16] = { 0x03, 0x88, 0xda, 0xce, 0x60, 0xb6, 0xa3, 0x92, 0xf3, 0x28, 0xc2, 0xb9, 0x71, 0xb2, 0xfe, 0x78 };
+const unsigned char gcm_tag[16] = { 0xab, 0x6e, 0x47, 0xd4, 0x2c, 0xec, 0x13, 0xbd, 0xf5, 0x3a, 0x67, 0xb2, 0x12, 0x57, 0xbd, 0xdf };
+
+bool known_answers()
+{
+    unsigned char block[16];
+    bool ok = true;
+
+    AES ecb;
+    ecb.encrypt(fips_plain, fips_key, block);
+    ok &= !memcmp(block, fips_cipher, 16);
+    ecb.decrypt(block, fips_key, block);
+    ok &= !memcmp(block, fips_plain, 16);
+
+    AES ctr;
+    unsigned char counter[16];
+    memcpy(counter, ctr_counter, 16);
+    ctr.key(ctr_key);
+    ctr.ctr(ctr_plain, block, 16, counter);
+    ok &= !memcmp(block, ctr_cipher, 16);
+
+    GCM<> gcm(gcm_key);
+    unsigned char tag[16];
+    memset(block, 0, 16);
+    gcm.start(gcm_iv);
+    gcm.encrypt(block, 16);
+    gcm.tag(tag);
+    ok &= !memcmp(block, gcm_cipher, 16) && !memcmp(tag, gcm_tag, 16);
+    gcm.start(gcm_iv);
+    gcm.decrypt(block, 16);
+    ok &= gcm.verify(tag);
+    tag[15] ^= 1;
+    gcm.start(gcm_iv);
+    gcm.decrypt(block, 16);
+    ok &= !gcm.verify(tag);
+
+    return ok;
+}
+
+unsigned long long throughput(TSC::Time_Stamp ticks)
+{
+    return ticks ? static_cast<unsigned long long>(SIZE) * ROUNDS * TSC::frequency() / ticks / 1024 : 0;
+}
+
+int main()
+{
+    cout << "AES test" << endl;
+
+    cout << "Known-answer tests: " << (known_answers() ? "passed" : "failed!") << endl;
+
+    TSC::Time_Stamp t0, t1;
+
+    AES ecb;
+    t0 = TSC::time_stamp();
+    for(unsigned int r = 0; r < ROUNDS; r++)
+        for(unsigned int i = 0; i < SIZE; i += 16)
+            ecb.encrypt(&buffer[i], fips_key, &buffer[i]);
+    t1 = TSC::time_stamp();
+    cout << "ECB (one block per call): " << throughput(t1 - t0) << " KB/s" << endl;
+
+    AES ctr;
+    unsigned char counter[16];
+    memcpy(counter, ctr_counter, 16);
+    ctr.key(ctr_key);
+    t0 = TSC::time_stamp();
+    for(unsigned int r = 0; r < ROUNDS; r++)
+        ctr.ctr(buffer, buffer, SIZE, counter);
+    t1 = TSC::time_stamp();
+    cout << "CTR (in place):           " << throughput(t1 - t0) << " KB/s" << endl;
+
+    GCM<> gcm(gcm_key);
+    unsigned char tag[16];
+    t0 = TSC::time_stamp();
+    for(unsigned int r = 0; r < ROUNDS; r++) {
+        gcm.start(gcm_iv);
+        gcm.encrypt(buffer, SIZE);
+        gcm.tag(tag);
+    }
+    t1 = TSC::time_stamp();
+    cout << "GCM (in place):           " << throughput(t1 - t0) << " KB/s" << endl;
+
+    cout << "I'm done, bye!" << endl;
+
+    return 0;
+}
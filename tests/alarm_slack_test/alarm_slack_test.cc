@@ -0,0 +1,73 @@
+// EPOS Alarm Slack Test Program (dispatches of many loose periodic alarms, without and with slack)
+
+// Slack lets alarms go off together, in fewer dispatches (i.e. ticks in which the alarm handlers run), but the timer
+// still interrupts on every tick, so the timer interrupts are reported next to them
+
+#include <time.h>
+
+using namespace EPOS;
+
+const unsigned int ALARMS = 8;
+const Microsecond PERIOD = 10000;  // the i-th alarm has PERIOD + i * STEP
+const Microsecond STEP = 3000;
+const Microsecond SLACK = 20000;
+const Microsecond DURATION = 2000000;
+
+OStream cout;
+
+unsigned int count[ALARMS];
+
+void tick(unsigned int * c) { (*c)++; }
+
+unsigned int interrupts;
+
+// Returns the number of dispatches (and leaves the number of timer interrupts in interrupts)
+unsigned int run(const Microsecond & slack)
+{
+    Functor_Handler<unsigned int> * handlers[ALARMS];
+    Alarm * alarms[ALARMS];
+
+    for(unsigned int i = 0; i < ALARMS; i++) {
+        count[i] = 0;
+        handlers[i] = new Functor_Handler<unsigned int>(&tick, &count[i]);
+    }
+
+    unsigned int dispatches = Alarm::dispatches();
+    interrupts = Alarm::interrupts();
+    for(unsigned int i = 0; i < ALARMS; i++)
+        alarms[i] = new Alarm(PERIOD + i * STEP, handlers[i], INFINITE, slack);
+
+    Alarm::delay(DURATION);
+    dispatches = Alarm::dispatches() - dispatches;
+    interrupts = Alarm::interrupts() - interrupts;
+
+    for(unsigned int i = 0; i < ALARMS; i++) {
+        delete alarms[i];
+        delete handlers[i];
+    }
+
+    return dispatches;
+}
+
+int main()
+{
+    cout << "Alarm slack test" << endl;
+
+    // The delay of run() itself takes a dispatch
+    unsigned int tight = run(0);
+    unsigned int expected = 0;
+    for(unsigned int i = 0; i < ALARMS; i++)
+        expected += DURATION / (PERIOD + i * STEP);
+    cout << "Without slack: " << tight << " dispatches for " << expected << " expirations (" << interrupts << " timer interrupts)" << endl;
+
+    // With slack, an alarm goes off from its period up to its period plus the slack, so it goes off fewer times
+    unsigned int loose = run(SLACK);
+    bool ok = true;
+    for(unsigned int i = 0; i < ALARMS; i++)
+        ok &= (count[i] >= DURATION / (PERIOD + i * STEP + SLACK)) && (count[i] <= DURATION / (PERIOD + i * STEP) + 1);
+    cout << "With " << SLACK << " us of slack: " << loose << " dispatches (" << interrupts << " timer interrupts, expiration counts " << (ok ? "passed" : "failed!") << ")" << endl;
+
+    cout << (((loose < tight) && ok) ? "I'm done, bye!" : "Some tests failed!") << endl;
+
+    return 0;
+}
@@ -35,6 +35,13 @@ template<> struct Traits<Debug>: public Traits<Build>
     static const bool warning = true;
     static const bool info    = false;
     static const bool trace   = false;
+
+    // Output goes to per-CPU rings drained by the idle thread, instead of straight to the Display (see utility/log.h)
+    static const bool buffered = false;
+    static const unsigned int BUFFER_SIZE = 4096; // per CPU, a power of two
+
+    // db<> lines become binary records (literals by address, arguments unformatted) for tools/eposlog to decode
+    static const bool binary = false;
 };
 
 template<> struct Traits<Lists>: public Traits<Build>
@@ -104,6 +111,7 @@ template<> struct Traits<System>: public Traits<Build>
 {
     static const unsigned int mode = Traits<Build>::MODE;
     static const bool multithread = (Traits<Application>::MAX_THREADS > 1);
+    static const bool multitask = (mode != Traits<Build>::LIBRARY);
     static const bool multiheap = Traits<Scratchpad>::enabled;
 
     static const unsigned long LIFE_SPAN = 1 * YEAR; // s
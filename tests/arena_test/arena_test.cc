@@ -0,0 +1,94 @@
+// EPOS Arena (Region Allocator) Test Program
+
+#include <architecture.h>
+#include <memory.h>
+
+using namespace EPOS;
+
+const unsigned int OBJECTS = 1000;
+
+struct Request
+{
+    Request(int i): id(i), next(0) {}
+
+    int id;
+    Request * next;
+};
+
+OStream cout;
+Request * heaped[OBJECTS];
+
+int main()
+{
+    cout << "Arena test" << endl;
+
+    Arena arena;
+    TSC::Time_Stamp t0 = TSC::time_stamp();
+    Request * list = 0;
+    for(unsigned int i = 0; i < OBJECTS; i++) {
+        Request * r = new (arena) Request(i);
+        r->next = list;
+        list = r;
+    }
+    TSC::Time_Stamp t1 = TSC::time_stamp();
+    cout << "Arena: " << OBJECTS << " objects in " << arena.chunks() << " chunks (" << arena.used() << " bytes) took " << t1 - t0 << " ticks" << endl;
+
+    t0 = TSC::time_stamp();
+    for(unsigned int i = 0; i < OBJECTS; i++)
+        heaped[i] = new Request(i);
+    t1 = TSC::time_stamp();
+    cout << "Heap:  " << OBJECTS << " objects took " << t1 - t0 << " ticks" << endl;
+    for(unsigned int i = 0; i < OBJECTS; i++)
+        delete heaped[i];
+
+    unsigned int sum = 0;
+    for(Request * r = list; r; r = r->next)
+        sum += r->id;
+    cout << "Checksum " << ((sum == OBJECTS * (OBJECTS - 1) / 2) ? "OK" : "failed!") << endl;
+
+    cout << "Nested scope: ";
+    Arena::Mark mark = arena.mark();
+    unsigned long before = arena.used();
+    for(unsigned int i = 0; i < OBJECTS; i++)
+        new (arena) char[100];
+    arena.release(mark);
+    cout << ((arena.used() == before) ? "rewound" : "failed!") << endl;
+
+    cout << "Child arena: ";
+    {
+        Arena child(&arena, 1024);
+        for(unsigned int i = 0; i < OBJECTS / 10; i++)
+            new (child) Request(i);
+        cout << child.chunks() << " chunks taken from the parent, which now has " << arena.used() << " bytes in use" << endl;
+    }
+
+    cout << "Tiny chunks: ";
+    {
+        Arena tiny(1); // smaller than a chunk's own header, so it gets clamped
+        bool ok = true;
+        for(unsigned int i = 0; i < OBJECTS / 10; i++) {
+            Request * r = new (tiny) Request(i);
+            ok &= (r != 0) && (r->id == static_cast<int>(i));
+        }
+        cout << tiny.chunks() << " chunks " << (ok ? "OK" : "failed!") << endl;
+    }
+
+    arena.reset();
+    cout << "Reset: " << arena.chunks() << " chunk(s), " << arena.used() << " bytes in use" << endl;
+
+    if(Traits<Build>::MODEL != Traits<Build>::SiFive_E) {
+        Segment * segment = new (SYSTEM) Segment(16 * 1024, Segment::Flags::SYS);
+        {
+            Arena fixed(segment);
+            unsigned int n = 0;
+            while(new (fixed) Request(n))
+                n++;
+            cout << "Segment arena: " << n << " objects before running out of its " << segment->size() << " bytes" << endl;
+        }
+        delete segment;
+    }
+
+    cout << "I'm done, bye!" << endl;
+
+    return 0;
+}
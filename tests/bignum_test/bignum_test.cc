@@ -0,0 +1,151 @@
+// EPOS Bignum Utility Test Program (modular arithmetic checks, and ECDH and Poly1305 timings)
+
+#include <architecture.h>
+#include <utility/aes.h>
+#include <utility/diffie_hellman.h>
+#include <utility/poly1305.h>
+
+using namespace EPOS;
+
+typedef SWAES<16> AES;
+typedef Diffie_Hellman<AES> DH;
+typedef Diffie_Hellman<AES, true> CT_DH;
+
+const unsigned int MULTIPLICATIONS = 1000;
+const unsigned int KEYS = 4;
+const unsigned int SIZE = 1024;
+const unsigned int STAMPS = 8;
+
+OStream cout;
+unsigned char message[SIZE];
+
+// Poly1305-AES, test vector #2 from Bernstein's paper
+const unsigned char poly_r[16] = { 0x85, 0x1f, 0xc4, 0x0c, 0x34, 0x67, 0xac, 0x0b, 0xe0, 0x5c, 0xc2, 0x04, 0x04, 0xf3, 0xf7, 0x00 };
+const unsigned char poly_k[16] = { 0xec, 0x07, 0x4c, 0x83, 0x55, 0x80, 0x74, 0x17, 0x01, 0x42, 0x5b, 0x62, 0x32, 0x35, 0xad, 0xd6 };
+const unsigned char poly_n[16] = { 0xfb, 0x44, 0x73, 0x50, 0xc4, 0xe8, 0x68, 0xc5, 0x2a, 0xc3, 0x27, 0x5c, 0xf9, 0xd4, 0x32, 0x7e };
+const unsigned char poly_m[2] = { 0xf3, 0xf6 };
+const unsigned char poly_mac[16] = { 0xf4, 0xc6, 0x33, 0xc3, 0x04, 0x4f, 0xc1, 0x45, 0xf8, 0x4f, 0x33, 0x5c, 0xb8, 0x19, 0x53, 0xde };
+
+// ECDH over secp128r1 with fixed private keys, with the expected public key and shared key (x ^ y of a * b * G)
+// computed independently from the curve's published parameters (all little-endian)
+const unsigned char ecdh_a[16] = { 0x21, 0x43, 0x65, 0x87, 0xa9, 0xcb, 0xed, 0x0f, 0xef, 0xcd, 0xab, 0x89, 0x67, 0x45, 0x23, 0x01 };
+const unsigned char ecdh_b[16] = { 0xb5, 0x00, 0x6b, 0xb1, 0xe0, 0xaf, 0xdc, 0xba, 0x0d, 0x90, 0x15, 0xee, 0xff, 0xc0, 0xd3, 0x5a };
+const unsigned char ecdh_a_x[16] = { 0x26, 0x7e, 0x34, 0xe2, 0x6b, 0x7d, 0x6d, 0xfd, 0x3b, 0xd5, 0x84, 0x27, 0x66, 0x7d, 0xc0, 0x04 };
+const unsigned char ecdh_a_y[16] = { 0xf4, 0xbd, 0xe1, 0xec, 0x92, 0x48, 0x27, 0x1c, 0xf2, 0x3e, 0x46, 0xcf, 0x91, 0xfa, 0x58, 0x59 };
+const unsigned char ecdh_shared[16] = { 0xe0, 0x13, 0xa2, 0x79, 0x99, 0x48, 0x02, 0xd6, 0xee, 0x8e, 0xdf, 0x04, 0xf6, 0x8a, 0x1a, 0xa7 };
+
+// (p - 1)^2 = 1 and a * a^-1 = 1 (mod p), whatever the digit size
+template<unsigned int SIZE>
+bool field()
+{
+    typedef Bignum<SIZE> Number;
+
+    bool ok = true;
+    Number one(1), a(0);
+    a -= one;
+    a *= a;
+    ok &= (a == one);
+
+    for(unsigned int i = 0; i < 16; i++) {
+        Number b, c;
+        b.randomize();
+        c = b;
+        c.invert();
+        c *= b;
+        ok &= (c == one);
+    }
+
+    return ok;
+}
+
+unsigned long long us(TSC::Time_Stamp ticks, unsigned int n)
+{
+    return static_cast<unsigned long long>(ticks) * 1000000 / TSC::frequency() / n;
+}
+
+template<typename ECDH>
+bool known_answer()
+{
+    typedef typename ECDH::Private_Key Key;
+    ECDH alice(Key(ecdh_a, 16)), bob(Key(ecdh_b, 16));
+    typename ECDH::Public_Key a = alice.public_key();
+    return (a.x == Key(ecdh_a_x, 16)) && (a.y == Key(ecdh_a_y, 16))
+        && (alice.shared_key(bob.public_key()) == Key(ecdh_shared, 16)) && (bob.shared_key(a) == Key(ecdh_shared, 16));
+}
+
+template<typename ECDH>
+void ecdh(const char * name)
+{
+    TSC::Time_Stamp t0, t1;
+    ECDH alice, bob;
+
+    t0 = TSC::time_stamp();
+    for(unsigned int i = 0; i < KEYS; i++)
+        ECDH dh;
+    t1 = TSC::time_stamp();
+    cout << name << " key pair generation: " << us(t1 - t0, KEYS) << " us" << endl;
+
+    t0 = TSC::time_stamp();
+    for(unsigned int i = 0; i < KEYS; i++)
+        alice.shared_key(bob.public_key());
+    t1 = TSC::time_stamp();
+    cout << name << " shared key: " << us(t1 - t0, KEYS) << " us" << endl;
+}
+
+int main()
+{
+    cout << "Bignum test (" << sizeof(Bignum<16>::Digit) * 8 << "-bit digits)" << endl;
+
+    bool ok = field<16>() && field<17>();
+
+    unsigned char mac[16];
+    Poly1305<AES> poly(poly_k, poly_r);
+    poly.stamp(mac, poly_n, poly_m, sizeof(poly_m));
+    ok &= !memcmp(mac, poly_mac, 16) && poly.verify(poly_mac, poly_n, poly_m, sizeof(poly_m));
+
+    // Streaming in uneven pieces must give the same MAC as a single call
+    for(unsigned int i = 0; i < SIZE; i++)
+        message[i] = i * 7;
+    unsigned char streamed[16];
+    poly.stamp(mac, poly_n, message, 100);
+    poly.start(poly_n);
+    poly.update(message, 5);
+    poly.update(message + 5, 40);
+    poly.update(message + 45, 55);
+    poly.finish(streamed);
+    ok &= !memcmp(mac, streamed, 16);
+
+    DH alice, bob;
+    ok &= (alice.shared_key(bob.public_key()) == bob.shared_key(alice.public_key()));
+    CT_DH carol, dave;
+    ok &= (carol.shared_key(dave.public_key()) == dave.shared_key(carol.public_key()));
+    ok &= known_answer<DH>() && known_answer<CT_DH>();
+
+    cout << "Field arithmetic, Poly1305 (one-shot and streamed) and ECDH (agreement and known answer): " << (ok ? "passed" : "failed!") << endl;
+
+    TSC::Time_Stamp t0, t1;
+
+    Bignum<16> a, b;
+    a.randomize();
+    b.randomize();
+    t0 = TSC::time_stamp();
+    for(unsigned int i = 0; i < MULTIPLICATIONS; i++)
+        a *= b;
+    t1 = TSC::time_stamp();
+    cout << "Modular multiplication (128 bits): " << us(t1 - t0, MULTIPLICATIONS) << " us" << endl;
+
+    ecdh<DH>("ECDH");
+    ecdh<CT_DH>("Constant-time ECDH");
+
+    for(unsigned int i = 0; i < SIZE; i++)
+        message[i] = i;
+    t0 = TSC::time_stamp();
+    for(unsigned int i = 0; i < STAMPS; i++)
+        poly.stamp(mac, poly_n, message, SIZE);
+    t1 = TSC::time_stamp();
+    cout << "Poly1305-AES stamp (" << SIZE << " bytes): " << us(t1 - t0, STAMPS) << " us" << endl;
+
+    cout << "I'm done, bye!" << endl;
+
+    return 0;
+}
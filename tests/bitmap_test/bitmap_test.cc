@@ -0,0 +1,93 @@
+// EPOS Bitmap Utility Test Program (searches, ranges and counts against bit-by-bit scans, and search timings)
+
+#include <architecture.h>
+#include <utility/bitmap.h>
+#include <utility/random.h>
+
+using namespace EPOS;
+
+const unsigned int SMALL = 100;   // a few words, no summaries
+const unsigned int LARGE = 4000;  // summarized
+const unsigned int ROUNDS = 200;
+
+OStream cout;
+
+// Checks every query against a bit-by-bit scan
+template<unsigned int BITS>
+bool check(const Bitmap<BITS> & map, unsigned int from)
+{
+    unsigned int first = BITS, zero = BITS, last = BITS, count = 0;
+    for(unsigned int i = 0; i < BITS; i++) {
+        if(map.test(i)) {
+            last = i;
+            count++;
+            if((i >= from) && (first == BITS))
+                first = i;
+        } else if((i >= from) && (zero == BITS))
+            zero = i;
+    }
+    return (map.find_first_set(from) == first) && (map.find_first_zero(from) == zero) && (map.find_last_set() == last)
+        && (map.count() == count) && (map.empty() == !count) && (map.full() == (count == BITS));
+}
+
+template<unsigned int BITS>
+bool random_operations()
+{
+    Bitmap<BITS> map;
+    bool ok = check(map, 0);
+    for(unsigned int r = 0; r < ROUNDS; r++) {
+        unsigned int i = Random::random(BITS + 2);
+        unsigned int n = Random::random(BITS / 4 + 1);
+        switch(r % 4) {
+        case 0: {
+            bool was = map.test(i);
+            ok &= (map.set(i) == ((i < BITS) && !was)) && ((i >= BITS) || map.test(i));
+        } break;
+        case 1: {
+            bool was = map.test(i);
+            ok &= (map.reset(i) == was) && !map.test(i);
+        } break;
+        case 2: map.set(i, n); break;
+        case 3: map.reset(i, n); break;
+        }
+        ok &= check(map, Random::random(BITS));
+    }
+    map.set(0, BITS);
+    ok &= map.full() && (map.count() == BITS) && (map.find_first_zero() == BITS);
+    map.reset(1, BITS);
+    ok &= (map.count() == 1) && (map.find_first_set(1) == BITS) && (map.find_last_set() == 0);
+    return ok;
+}
+
+int main()
+{
+    cout << "Bitmap test" << endl;
+
+    bool ok = random_operations<1>() && random_operations<SMALL>() && random_operations<LARGE>();
+    cout << "Searches, ranges and counts: " << (ok ? "passed" : "failed!") << endl;
+
+    // An ID allocator over a nearly full map: the only free bit is the last one
+    Bitmap<LARGE> ids;
+    ids.set(0, LARGE - 1);
+    volatile unsigned int sink = 0;
+
+    TSC::Time_Stamp t0 = TSC::time_stamp();
+    for(unsigned int r = 0; r < ROUNDS; r++)
+        sink = sink + ids.find_first_zero();
+    TSC::Time_Stamp t1 = TSC::time_stamp();
+    cout << "find_first_zero() on " << LARGE << " bits: " << static_cast<unsigned long long>(t1 - t0) * 1000000000 / TSC::frequency() / ROUNDS << " ns" << endl;
+
+    t0 = TSC::time_stamp();
+    for(unsigned int r = 0; r < ROUNDS; r++)
+        for(unsigned int i = 0; i < LARGE; i++)
+            if(!ids.test(i)) {
+                sink = sink + i;
+                break;
+            }
+    t1 = TSC::time_stamp();
+    cout << "Bit-by-bit search on " << LARGE << " bits: " << static_cast<unsigned long long>(t1 - t0) * 1000000000 / TSC::frequency() / ROUNDS << " ns" << endl;
+
+    cout << "I'm done, bye!" << endl;
+
+    return 0;
+}
@@ -0,0 +1,83 @@
+// EPOS CRC Utility Test Program (check values and throughput of each method)
+
+#include <architecture.h>
+#include <utility/crc.h>
+
+using namespace EPOS;
+
+const unsigned int SIZE = (Traits<Build>::MODEL == Traits<Build>::SiFive_E) ? 2 * 1024 : 16 * 1024; // SiFive-E has only 16 KB of RAM
+const unsigned int ROUNDS = 8;
+
+OStream cout;
+unsigned char data[SIZE + 1];
+
+const char * name(CRC::Method m)
+{
+    switch(m) {
+    case CRC::BITWISE:   return "bitwise  ";
+    case CRC::BYTEWISE:  return "bytewise ";
+    case CRC::SLICING_4: return "slicing-4";
+    case CRC::SLICING_8: return "slicing-8";
+    default:             return CRC::hardware ? "hardware " : "hardware (slicing-8)";
+    }
+}
+
+unsigned long long throughput(TSC::Time_Stamp ticks)
+{
+    return ticks ? static_cast<unsigned long long>(SIZE) * ROUNDS * TSC::frequency() / ticks / 1024 : 0;
+}
+
+int main()
+{
+    cout << "CRC test" << endl;
+
+    const CRC::Method methods[] = { CRC::BITWISE, CRC::BYTEWISE, CRC::SLICING_4, CRC::SLICING_8, CRC::HARDWARE };
+    const char * check = "123456789";
+
+    for(unsigned int i = 0; i < SIZE + 1; i++)
+        data[i] = i * 13 + 5;
+
+    bool ok = true;
+    for(unsigned int m = 0; m < sizeof(methods) / sizeof(CRC::Method); m++) {
+        // Check values from the CRC catalogue
+        ok &= CRC::crc16(check, 9, 0, methods[m]) == 0x31c3;
+        ok &= CRC::crc32(check, 9, 0, methods[m]) == 0xcbf43926;
+        ok &= CRC::crc32c(check, 9, 0, methods[m]) == 0xe3069283;
+
+        // Misaligned buffers, and streaming in two pieces must give the same result as a single pass
+        unsigned int whole = CRC::crc32c(&data[1], SIZE, 0, CRC::BITWISE);
+        ok &= CRC::crc32c(&data[1], SIZE, 0, methods[m]) == whole;
+        ok &= CRC::crc32c(&data[1 + 1000], SIZE - 1000, CRC::crc32c(&data[1], 1000, 0, methods[m]), methods[m]) == whole;
+    }
+    cout << "Check values and streaming: " << (ok ? "passed" : "failed!") << endl;
+
+    cout << "Throughput over " << SIZE / 1024 << " KB (KB/s):" << endl;
+    for(unsigned int m = 0; m < sizeof(methods) / sizeof(CRC::Method); m++) {
+        volatile unsigned int sink = 0;
+        TSC::Time_Stamp t0, t1;
+
+        t0 = TSC::time_stamp();
+        for(unsigned int r = 0; r < ROUNDS; r++)
+            sink = sink + CRC::crc16(data, SIZE, 0, methods[m]);
+        t1 = TSC::time_stamp();
+        unsigned long long crc16 = throughput(t1 - t0);
+
+        t0 = TSC::time_stamp();
+        for(unsigned int r = 0; r < ROUNDS; r++)
+            sink = sink + CRC::crc32(data, SIZE, 0, methods[m]);
+        t1 = TSC::time_stamp();
+        unsigned long long crc32 = throughput(t1 - t0);
+
+        t0 = TSC::time_stamp();
+        for(unsigned int r = 0; r < ROUNDS; r++)
+            sink = sink + CRC::crc32c(data, SIZE, 0, methods[m]);
+        t1 = TSC::time_stamp();
+        unsigned long long crc32c = throughput(t1 - t0);
+
+        cout << "  " << name(methods[m]) << ": CRC-16=" << crc16 << ", CRC-32=" << crc32 << ", CRC-32C=" << crc32c << endl;
+    }
+
+    cout << "I'm done, bye!" << endl;
+
+    return 0;
+}
@@ -0,0 +1,95 @@
+// EPOS Hash Utility Test Program (Flat_Hash operations against the chained Simple_Hash, and lookup timings)
+
+#include <architecture.h>
+#include <utility/hash.h>
+
+using namespace EPOS;
+
+const unsigned int ENTRIES = (Traits<Build>::MODEL == Traits<Build>::SiFive_E) ? 128 : 1024; // SiFive-E has only 16 KB of RAM
+const unsigned int BUCKETS = 64;
+const unsigned int ROUNDS = 8;
+
+struct Flow { int key; };
+
+typedef Simple_Hash<Flow, BUCKETS> Chained;
+
+OStream cout;
+Flow flows[ENTRIES];
+
+unsigned long long ns(TSC::Time_Stamp ticks, unsigned int n)
+{
+    return static_cast<unsigned long long>(ticks) * 1000000000 / TSC::frequency() / n;
+}
+
+int main()
+{
+    cout << "Hash test" << endl;
+
+    Flat_Hash<Flow> flat;
+    Chained chained;
+    Chained::Element * links = reinterpret_cast<Chained::Element *>(malloc(ENTRIES * sizeof(Chained::Element)));
+
+    // Keys spaced so that many share their low bits
+    for(unsigned int i = 0; i < ENTRIES; i++) {
+        flows[i].key = i * BUCKETS + (i % 3);
+        new (&links[i]) Chained::Element(&flows[i], flows[i].key);
+        chained.insert(&links[i]);
+    }
+
+    bool ok = true;
+    for(unsigned int i = 0; i < ENTRIES; i++)
+        ok &= flat.insert(&flows[i], flows[i].key);
+    ok &= !flat.insert(&flows[0], flows[0].key) && (flat.size() == ENTRIES);
+
+    for(unsigned int i = 0; i < ENTRIES; i++)
+        ok &= (flat.search_key(flows[i].key) == &flows[i]) && !flat.search_key(flows[i].key + 3);
+
+    // Removing every other object must leave the rest reachable (backward shifts keep clusters intact)
+    for(unsigned int i = 0; i < ENTRIES; i += 2)
+        ok &= (flat.remove(&flows[i], flows[i].key) == &flows[i]) && !flat.remove(&flows[i + 1], flows[i].key);
+    for(unsigned int i = 0; i < ENTRIES; i++)
+        ok &= (flat.search_key(flows[i].key) == ((i % 2) ? &flows[i] : 0));
+
+    unsigned int n = 0;
+    for(Flat_Hash<Flow>::Iterator it = flat.begin(); it != flat.end(); it++, n++)
+        ok &= (it->object()->key == it->key()) && (it->key() / BUCKETS % 2);
+    ok &= (n == ENTRIES / 2) && (flat.size() == ENTRIES / 2);
+
+    for(unsigned int i = 0; i < ENTRIES; i += 2)
+        ok &= flat.insert(&flows[i], flows[i].key);
+
+    // A table that never allocated must be destroyable, and a fresh one must take its first block without freeing any
+    {
+        Flat_Hash<Flow> empty;
+        ok &= empty.empty() && !empty.search_key(flows[0].key);
+    }
+    {
+        Flat_Hash<Flow> fresh;
+        for(unsigned int i = 0; i < 16; i++)
+            ok &= fresh.insert(&flows[i], flows[i].key);
+        ok &= (fresh.size() == 16) && (fresh.search_key(flows[15].key) == &flows[15]);
+    }
+
+    cout << "Insertion, lookup, removal, iteration and empty tables: " << (ok ? "passed" : "failed!") << endl;
+
+    volatile unsigned long sink = 0;
+    TSC::Time_Stamp t0, t1;
+
+    t0 = TSC::time_stamp();
+    for(unsigned int r = 0; r < ROUNDS; r++)
+        for(unsigned int i = 0; i < ENTRIES; i++)
+            sink = sink + reinterpret_cast<unsigned long>(chained.search_key(flows[i].key));
+    t1 = TSC::time_stamp();
+    cout << "Simple_Hash<" << BUCKETS << "> lookup with " << ENTRIES << " entries: " << ns(t1 - t0, ROUNDS * ENTRIES) << " ns" << endl;
+
+    t0 = TSC::time_stamp();
+    for(unsigned int r = 0; r < ROUNDS; r++)
+        for(unsigned int i = 0; i < ENTRIES; i++)
+            sink = sink + reinterpret_cast<unsigned long>(flat.search_key(flows[i].key));
+    t1 = TSC::time_stamp();
+    cout << "Flat_Hash lookup with " << ENTRIES << " entries (capacity " << flat.capacity() << "): " << ns(t1 - t0, ROUNDS * ENTRIES) << " ns" << endl;
+
+    cout << "I'm done, bye!" << endl;
+
+    return 0;
+}
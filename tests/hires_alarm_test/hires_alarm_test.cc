@@ -0,0 +1,55 @@
+// EPOS High-Resolution Alarm Test Program (release jitter of periodic waits on absolute deadlines, and short delays)
+
+#include <time.h>
+
+using namespace EPOS;
+
+const unsigned int ITERATIONS = 100;
+const Microsecond PERIODS[] = { 250, 1500, 10000 };
+const long long TOLERANCE = 10; // us
+
+OStream cout;
+
+long long us(long long ticks) { return ticks * 1000000 / static_cast<long long>(TSC::frequency()); }
+
+int main()
+{
+    cout << "High-resolution Alarm test" << endl;
+
+    bool ok = true;
+
+    // Releases are absolute, so a late one doesn't push the following ones
+    for(unsigned int p = 0; p < sizeof(PERIODS) / sizeof(Microsecond); p++) {
+        Alarm::Time_Stamp period = Alarm::deadline(PERIODS[p]) - Alarm::deadline(0);
+        Alarm::Time_Stamp release = Alarm::deadline(PERIODS[p]);
+        long long min = 0, max = 0;
+
+        for(unsigned int i = 0; i < ITERATIONS; i++, release += period) {
+            Alarm::delay_until(release);
+            long long late = static_cast<long long>(TSC::time_stamp() - release);
+            if((i == 0) || (late < min))
+                min = late;
+            if((i == 0) || (late > max))
+                max = late;
+        }
+
+        bool passed = (min >= 0) && (us(max) <= TOLERANCE);
+        ok &= passed;
+        cout << "Period " << PERIODS[p] << " us: release jitter in [" << us(min) << ", " << us(max) << "] us "
+             << (passed ? "(passed)" : "(failed!)") << endl;
+    }
+
+    // Delays shorter than the wakeup latency don't sleep
+    long long latency = Alarm::latency();
+    TSC::Time_Stamp t0 = TSC::time_stamp();
+    Alarm::delay(latency / 2);
+    long long elapsed = us(TSC::time_stamp() - t0);
+    bool passed = (elapsed >= latency / 2) && (elapsed <= latency / 2 + TOLERANCE);
+    ok &= passed;
+    cout << "Delay of " << latency / 2 << " us (wakeup latency is " << latency << " us) took " << elapsed << " us "
+         << (passed ? "(passed)" : "(failed!)") << endl;
+
+    cout << (ok ? "I'm done, bye!" : "Some tests failed!") << endl;
+
+    return 0;
+}
@@ -0,0 +1,43 @@
+// EPOS Buffered Log Test Program (cost of a printed line, draining by the idle thread and overflow accounting)
+
+#include <time.h>
+#include <utility/log.h>
+
+using namespace EPOS;
+
+const unsigned int LINES = 32;
+
+OStream cout;
+
+unsigned long long ns(TSC::Time_Stamp ticks, unsigned int n)
+{
+    return static_cast<unsigned long long>(ticks) * 1000000000 / TSC::frequency() / n;
+}
+
+int main()
+{
+    cout << "Log test" << endl;
+
+    // Lines only get copied to the ring here; the UART sees them when this thread sleeps and the idle thread runs
+    TSC::Time_Stamp t0 = TSC::time_stamp();
+    for(unsigned int i = 0; i < LINES; i++)
+        cout << "Line " << i << " of " << LINES << endl;
+    TSC::Time_Stamp t1 = TSC::time_stamp();
+    unsigned long long line = ns(t1 - t0, LINES);
+
+    Delay(100000);
+    cout << "A buffered line cost " << line << " ns" << endl;
+
+    // Printing much more than a ring holds without sleeping must drop text, and count it
+    unsigned int lost = Log::lost();
+    for(unsigned int i = 0; i < Traits<Debug>::BUFFER_SIZE / 8; i++)
+        cout << "Flood " << i << endl;
+    bool ok = (Log::lost() > lost);
+
+    Delay(100000);
+    cout << "Overflow accounting: " << (ok ? "passed" : "failed!") << " (" << Log::lost() - lost << " bytes lost)" << endl;
+
+    cout << "I'm done, bye!" << endl;
+
+    return 0;
+}
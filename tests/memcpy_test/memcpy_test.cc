@@ -0,0 +1,125 @@
+// EPOS Memory Primitives Test Program (correctness and bandwidth of memcpy, memset and memcmp)
+
+#include <architecture.h>
+#include <utility/string.h>
+
+using namespace EPOS;
+
+const unsigned int BUF_SIZE = 64 * 1024;
+const unsigned int CHECK_SIZE = 160;
+const unsigned int OFFSETS = 8;
+const unsigned int ROUNDS = 16;
+
+OStream cout;
+char src[BUF_SIZE + OFFSETS];
+char dst[BUF_SIZE + OFFSETS];
+
+// Plain byte loop used both as the reference for the checks and as the baseline for the bandwidth figures
+void * reference_copy(void * d, const void * s, size_t n)
+{
+    char * dc = reinterpret_cast<char *>(d);
+    const char * sc = reinterpret_cast<const char *>(s);
+    while(n--)
+        *dc++ = *sc++;
+    return d;
+}
+
+bool check()
+{
+    for(unsigned int i = 0; i < CHECK_SIZE + 2 * OFFSETS; i++)
+        src[i] = i * 7 + 1;
+
+    for(unsigned int so = 0; so < OFFSETS; so++)
+        for(unsigned int d = 0; d < OFFSETS; d++)
+            for(unsigned int n = 0; n <= CHECK_SIZE; n++) {
+                memset(dst, 0, CHECK_SIZE + 2 * OFFSETS);
+                memcpy(&dst[d], &src[so], n);
+                for(unsigned int i = 0; i < CHECK_SIZE + 2 * OFFSETS; i++)
+                    if(dst[i] != (((i >= d) && (i < d + n)) ? src[so + i - d] : 0)) {
+                        cout << "memcpy(dst+" << d << ", src+" << so << ", " << n << ") failed at " << i << "!" << endl;
+                        return false;
+                    }
+
+                if(memcmp(&dst[d], &src[so], n)) {
+                    cout << "memcmp(dst+" << d << ", src+" << so << ", " << n << ") reported a difference!" << endl;
+                    return false;
+                }
+                if(n) {
+                    dst[d + n - 1] ^= 0x80;
+                    int expected = static_cast<unsigned char>(dst[d + n - 1]) - static_cast<unsigned char>(src[so + n - 1]);
+                    if((memcmp(&dst[d], &src[so], n) > 0) != (expected > 0)) {
+                        cout << "memcmp(dst+" << d << ", src+" << so << ", " << n << ") missed the last byte!" << endl;
+                        return false;
+                    }
+                }
+
+                memset(&dst[d], 0x5a, n);
+                for(unsigned int i = 0; i < CHECK_SIZE + 2 * OFFSETS; i++)
+                    if(dst[i] != (((i >= d) && (i < d + n)) ? 0x5a : 0)) {
+                        cout << "memset(dst+" << d << ", 0x5a, " << n << ") failed at " << i << "!" << endl;
+                        return false;
+                    }
+            }
+
+    return true;
+}
+
+unsigned long long bandwidth(unsigned long long bytes, TSC::Time_Stamp ticks)
+{
+    return ticks ? bytes * TSC::frequency() / ticks / (1024 * 1024) : 0;
+}
+
+void measure(unsigned int size, unsigned int offset)
+{
+    TSC::Time_Stamp t0, t1;
+    unsigned long long bytes = static_cast<unsigned long long>(size) * ROUNDS;
+
+    t0 = TSC::time_stamp();
+    for(unsigned int r = 0; r < ROUNDS; r++)
+        reference_copy(&dst[offset], src, size);
+    t1 = TSC::time_stamp();
+    unsigned long long base = bandwidth(bytes, t1 - t0);
+
+    t0 = TSC::time_stamp();
+    for(unsigned int r = 0; r < ROUNDS; r++)
+        memcpy(&dst[offset], src, size);
+    t1 = TSC::time_stamp();
+    unsigned long long copy = bandwidth(bytes, t1 - t0);
+
+    t0 = TSC::time_stamp();
+    for(unsigned int r = 0; r < ROUNDS; r++)
+        memset(&dst[offset], r, size);
+    t1 = TSC::time_stamp();
+    unsigned long long set = bandwidth(bytes, t1 - t0);
+
+    memcpy(dst, src, size);
+    int result = 0;
+    t0 = TSC::time_stamp();
+    for(unsigned int r = 0; r < ROUNDS; r++)
+        result |= memcmp(dst, src, size);
+    t1 = TSC::time_stamp();
+    unsigned long long compare = bandwidth(bytes, t1 - t0);
+
+    cout << "  " << size << " bytes" << (offset ? " (misaligned)" : "") << ": byte loop=" << base << ", memcpy=" << copy
+         << ", memset=" << set << ", memcmp=" << compare << (result ? " (mismatch!)" : "") << " MB/s" << endl;
+}
+
+int main()
+{
+    cout << "Memory primitives test" << endl;
+
+    cout << "Checking all alignments and sizes up to " << CHECK_SIZE << " bytes: " << (check() ? "passed" : "failed!") << endl;
+
+    for(unsigned int i = 0; i < BUF_SIZE; i++)
+        src[i] = i;
+
+    cout << "Bandwidth (" << ROUNDS << " rounds each):" << endl;
+    for(unsigned int size = 64; size <= BUF_SIZE; size *= 4) {
+        measure(size, 0);
+        measure(size, 3);
+    }
+
+    cout << "I'm done, bye!" << endl;
+
+    return 0;
+}
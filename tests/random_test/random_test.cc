@@ -0,0 +1,72 @@
+// EPOS Random Utility Test Program (known answers, bounded ranges, bulk filling and throughput)
+
+#include <architecture.h>
+#include <utility/random.h>
+
+using namespace EPOS;
+
+const unsigned int NUMBERS = 10000;
+const unsigned int BUCKETS = 10;
+const unsigned int SIZE = 1024;
+
+OStream cout;
+unsigned char buffer[SIZE + 3];
+
+int main()
+{
+    cout << "Random test" << endl;
+
+    // SplitMix64 expansion of seed 42 followed by xoshiro128**, as computed by the reference algorithm
+    Random::Generator g(42);
+    bool ok = (g.next() == 1776835114U) && (g.next() == 4165204688U) && (g.next() == 17111135U);
+
+    // Bounded numbers stay in range and spread evenly over it
+    unsigned int buckets[BUCKETS] = { 0 };
+    for(unsigned int i = 0; i < NUMBERS; i++) {
+        unsigned int n = Random::random(BUCKETS);
+        ok &= (n < BUCKETS);
+        if(n < BUCKETS)
+            buckets[n]++;
+        int m = Random::random(-3, 3);
+        ok &= (m >= -3) && (m <= 3);
+    }
+    for(unsigned int i = 0; i < BUCKETS; i++)
+        ok &= (buckets[i] > NUMBERS / BUCKETS * 8 / 10) && (buckets[i] < NUMBERS / BUCKETS * 12 / 10);
+
+    // fill() writes the same numbers as next(), little-endian, and nothing past the end
+    Random::Generator a(7), b(7);
+    buffer[SIZE + 2] = 0x5a;
+    a.fill(&buffer[1], SIZE + 1);
+    for(unsigned int i = 0; i < SIZE; i += 4) {
+        unsigned int r = b.next();
+        ok &= (buffer[1 + i] == (r & 0xff)) && (buffer[1 + i + 3] == (r >> 24));
+    }
+    ok &= (buffer[1 + SIZE] == (b.next() & 0xff)) && (buffer[SIZE + 2] == 0x5a);
+
+    cout << "Known answers, ranges and fill: " << (ok ? "passed" : "failed!") << endl;
+
+    TSC::Time_Stamp t0, t1;
+    volatile unsigned int sink = 0;
+
+    t0 = TSC::time_stamp();
+    for(unsigned int i = 0; i < NUMBERS; i++)
+        sink = sink + Random::random();
+    t1 = TSC::time_stamp();
+    cout << "Random::random(): " << static_cast<unsigned long long>(t1 - t0) * 1000000000 / TSC::frequency() / NUMBERS << " ns" << endl;
+
+    t0 = TSC::time_stamp();
+    for(unsigned int i = 0; i < NUMBERS; i++)
+        sink = sink + Random::random(1000U);
+    t1 = TSC::time_stamp();
+    cout << "Random::random(1000): " << static_cast<unsigned long long>(t1 - t0) * 1000000000 / TSC::frequency() / NUMBERS << " ns" << endl;
+
+    t0 = TSC::time_stamp();
+    for(unsigned int i = 0; i < NUMBERS / (SIZE / 4); i++)
+        Random::fill(buffer, SIZE);
+    t1 = TSC::time_stamp();
+    cout << "Random::fill(" << SIZE << "): " << static_cast<unsigned long long>(t1 - t0) * 1000000000 / TSC::frequency() / (NUMBERS / (SIZE / 4)) << " ns" << endl;
+
+    cout << "I'm done, bye!" << endl;
+
+    return 0;
+}
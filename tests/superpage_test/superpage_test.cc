@@ -0,0 +1,74 @@
+// EPOS Superpage Test Program (TLB misses with small pages versus superpages)
+
+// Only IA32 translates addresses for the kernel (RISC-V runs it in machine mode, where satp has no effect), so this test
+// is built in kernel mode for the PC. Cycles come from the TSC and data TLB misses from Sandy Bridge's page walk counters
+// (DTLB_LOAD_MISSES.WALK_COMPLETED and DTLB_STORE_MISSES.WALK_COMPLETED), on the first two programmable PMU channels.
+
+#include <architecture.h>
+#include <memory.h>
+
+using namespace EPOS;
+
+const unsigned int SIZE = 8 * 1024 * 1024; // a multiple of both IA32's 4 MB and Sv39's 2 MB superpages
+const unsigned int PASSES = 16;
+
+const unsigned int LOAD_WALKS = 3;  // first programmable channel (0 to 2 are fixed on IA32)
+const unsigned int STORE_WALKS = 4;
+
+#ifdef __ia32__
+const PMU::Event LOAD_WALKS_COMPLETED = PMU::ARCHITECTURE_DEPENDENT_EVENT65;   // DTLB_LOAD_MISSES_MISS_WALK_COMPLETED
+const PMU::Event STORE_WALKS_COMPLETED = PMU::ARCHITECTURE_DEPENDENT_EVENT116; // DTLB_STORE_MISSES_WALK_COMPLETED
+#else
+const PMU::Event LOAD_WALKS_COMPLETED = PMU::DATA_TLB_MISSES;
+const PMU::Event STORE_WALKS_COMPLETED = PMU::DATA_TLB_MISSES;
+#endif
+
+OStream cout;
+
+void touch(const char * name, Segment * seg, unsigned int size)
+{
+    Address_Space self(MMU::current());
+    volatile char * base = self.attach(seg);
+
+    PMU::write(LOAD_WALKS, 0);
+    PMU::write(STORE_WALKS, 0);
+    TSC::Time_Stamp t0 = TSC::time_stamp();
+    for(unsigned int p = 0; p < PASSES; p++)
+        for(unsigned int i = 0; i < size; i += sizeof(MMU::Page))
+            base[i]++;
+    TSC::Time_Stamp cycles = TSC::time_stamp() - t0;
+    PMU::Count misses = PMU::read(LOAD_WALKS) + PMU::read(STORE_WALKS);
+
+    cout << "  " << name << ": " << size / 1024 << " KB at " << reinterpret_cast<void *>(const_cast<char *>(base))
+         << " => phy=" << seg->phy_address() << ", TLB misses=" << misses << ", cycles=" << cycles << endl;
+
+    self.detach(seg);
+}
+
+int main()
+{
+    cout << "Superpage test" << endl;
+
+    if((Traits<Build>::ARCHITECTURE != Traits<Build>::IA32) || (Traits<Build>::MODE == Traits<Build>::LIBRARY)) {
+        cout << "This test needs address translation in the kernel, which only IA32 has (in kernel mode)!" << endl;
+        return 0;
+    }
+
+    PMU::config(LOAD_WALKS, LOAD_WALKS_COMPLETED);
+    PMU::config(STORE_WALKS, STORE_WALKS_COMPLETED);
+
+    cout << "Touching every page of each segment " << PASSES << " times:" << endl;
+
+    // One page short of a superpage multiple, so it gets mapped with small pages only
+    Segment * small = new (SYSTEM) Segment(SIZE - sizeof(MMU::Page), Segment::Flags::SYS);
+    touch("small pages", small, SIZE - sizeof(MMU::Page));
+    delete small;
+
+    Segment * large = new (SYSTEM) Segment(SIZE, Segment::Flags::SYS);
+    touch("superpages ", large, SIZE);
+    delete large;
+
+    cout << "I'm done, bye!" << endl;
+
+    return 0;
+}
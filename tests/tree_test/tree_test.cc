@@ -0,0 +1,108 @@
+// EPOS Tree Utility Test Program (Ordered_Tree_Queue against Ordered_Queue, and insertion and removal timings)
+
+#include <architecture.h>
+#include <utility/queue.h>
+#include <utility/random.h>
+
+using namespace EPOS;
+
+const unsigned int ENTRIES = (Traits<Build>::MODEL == Traits<Build>::SiFive_E) ? 64 : 512; // SiFive-E has only 16 KB of RAM
+const unsigned int OPERATIONS = 4 * ENTRIES;
+const unsigned int RANKS = 100;
+
+struct Job { unsigned int id; };
+
+typedef Ordered_Queue<Job> List_Queue;
+typedef Ordered_Tree_Queue<Job> Tree_Queue;
+
+OStream cout;
+Job jobs[ENTRIES];
+List_Queue::Element * list_links[ENTRIES];
+Tree_Queue::Element * tree_links[ENTRIES];
+int ranks[ENTRIES];
+
+// Both queues must hold the same objects in the same order
+bool same(List_Queue & list, Tree_Queue & tree)
+{
+    if(list.size() != tree.size())
+        return false;
+    List_Queue::Element * l = list.head();
+    Tree_Queue::Element * t = tree.head();
+    for(; l && t; l = l->next(), t = t->next())
+        if((l->object() != t->object()) || (l->rank() != t->rank()) || (t->next() && (t->next()->prev() != t)))
+            return false;
+    return !l && !t && (tree.tail() ? tree.tail()->object() == list.tail()->object() : !list.tail());
+}
+
+template<typename Queue>
+unsigned long long churn(Queue & queue, typename Queue::Element ** links)
+{
+    // Fill the queue, then remove arbitrary elements and put them back with new ranks
+    for(unsigned int i = 0; i < ENTRIES; i++)
+        queue.insert(links[i]);
+
+    TSC::Time_Stamp t0 = TSC::time_stamp();
+    for(unsigned int i = 0; i < OPERATIONS; i++) {
+        unsigned int j = (i * 37) % ENTRIES;
+        queue.remove(links[j]);
+        links[j]->rank(ranks[(j + i) % ENTRIES]);
+        queue.insert(links[j]);
+    }
+    TSC::Time_Stamp t1 = TSC::time_stamp();
+
+    while(!queue.empty())
+        queue.remove();
+
+    return static_cast<unsigned long long>(t1 - t0) * 1000000000 / TSC::frequency() / OPERATIONS;
+}
+
+int main()
+{
+    cout << "Tree test" << endl;
+
+    List_Queue list;
+    Tree_Queue tree;
+    for(unsigned int i = 0; i < ENTRIES; i++) {
+        jobs[i].id = i;
+        ranks[i] = Random::random(RANKS);
+        list_links[i] = new List_Queue::Element(&jobs[i], ranks[i]);
+        tree_links[i] = new Tree_Queue::Element(&jobs[i], ranks[i]);
+    }
+
+    // Random insertions and removals (of the head, by element and by object), with repeated ranks to check stability
+    bool ok = true;
+    bool in[ENTRIES] = { false };
+    for(unsigned int i = 0; i < OPERATIONS; i++) {
+        unsigned int j = Random::random(ENTRIES);
+        if(!in[j]) {
+            list.insert(list_links[j]);
+            tree.insert(tree_links[j]);
+            in[j] = true;
+        } else if(i % 3 == 0) {
+            List_Queue::Element * l = list.remove();
+            Tree_Queue::Element * t = tree.remove();
+            ok &= (l->object() == t->object());
+            in[l->object()->id] = false;
+        } else if(i % 3 == 1) {
+            ok &= (list.remove(list_links[j]) == list_links[j]) && (tree.remove(tree_links[j]) == tree_links[j]);
+            in[j] = false;
+        } else {
+            ok &= (list.remove(&jobs[j]) == list_links[j]) && (tree.remove(&jobs[j]) == tree_links[j]);
+            in[j] = false;
+        }
+        ok &= same(list, tree);
+    }
+    while(!list.empty())
+        ok &= (list.remove()->object() == tree.remove()->object());
+    ok &= tree.empty() && !tree.head() && !tree.tail();
+
+    cout << "Order against Ordered_Queue: " << (ok ? "passed" : "failed!") << endl;
+
+    cout << "Remove and insert with " << ENTRIES << " elements:" << endl;
+    cout << "  Ordered_Queue: " << churn(list, list_links) << " ns" << endl;
+    cout << "  Ordered_Tree_Queue: " << churn(tree, tree_links) << " ns" << endl;
+
+    cout << "I'm done, bye!" << endl;
+
+    return 0;
+}
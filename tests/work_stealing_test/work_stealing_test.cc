@@ -0,0 +1,67 @@
+// EPOS Work-Stealing Scheduler Test Program (steal() of workers placed on another CPU's queue, with and without affinity)
+
+// This is not a benchmark: without SMP bring-up only CPU 0 runs, so it just checks that an idle CPU takes unpinned
+// threads from another CPU's queue and leaves pinned ones alone
+
+#include <process.h>
+
+using namespace EPOS;
+
+const unsigned int WORKERS = 12;
+const unsigned int PINNED = 4;  // the first PINNED workers may only run on their CPU
+const unsigned int HOME = 1;    // CPU whose queue all the workers are placed on
+const unsigned int UNIT = 100000;
+
+OStream cout;
+
+Thread * workers[WORKERS];
+volatile bool ran[WORKERS];
+volatile unsigned int ran_on[WORKERS];
+
+void spin(unsigned int units)
+{
+    for(volatile unsigned int i = 0; i < units * UNIT; i++);
+}
+
+// Worker n does n + 1 units of work, so they don't all finish together
+int work(unsigned int n)
+{
+    ran[n] = true;
+    ran_on[n] = CPU::id();
+    spin(n + 1);
+    return n;
+}
+
+int main()
+{
+    cout << "Work-stealing scheduler test (" << Traits<Build>::CPUS << " CPUs)" << endl;
+
+    // CPU 0 only gets to run workers from CPU HOME's queue by stealing them when it goes idle (i.e. while main waits
+    // for them). Pinned workers must never be taken, even if HOME never comes to run them (e.g. without SMP bring-up).
+    for(unsigned int i = 0; i < WORKERS; i++)
+        workers[i] = new Thread(Thread::Configuration(Thread::READY, WSRR(Thread::NORMAL, HOME, (i < PINNED) ? (1 << HOME) : WSRR::ANY)), &work, i);
+
+    bool stolen = true;
+    for(unsigned int i = PINNED; i < WORKERS; i++)
+        stolen &= (workers[i]->join() == static_cast<int>(i)) && ran[i];
+
+    unsigned int on_zero = 0;
+    for(unsigned int i = PINNED; i < WORKERS; i++)
+        on_zero += (ran_on[i] == 0);
+
+    // Pinned workers either stayed queued at HOME or ran there
+    bool pinned = true;
+    for(unsigned int i = 0; i < PINNED; i++)
+        pinned &= !ran[i] || (ran_on[i] == HOME);
+
+    for(unsigned int i = 0; i < WORKERS; i++)
+        delete workers[i];
+
+    cout << "Unpinned workers: " << WORKERS - PINNED << " done, " << on_zero << " of them on CPU 0 "
+         << (stolen ? "(passed)" : "(failed!)") << endl;
+    cout << "Pinned workers: " << (pinned ? "never stolen (passed)" : "stolen (failed!)") << endl;
+
+    cout << "I'm done, bye!" << endl;
+
+    return 0;
+}
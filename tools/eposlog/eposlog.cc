@@ -0,0 +1,284 @@
+/*=======================================================================*/
+/* eposlog.cc                                                            */
+/*                                                                       */
+/* Desc: Tool to decode EPOS binary logs (Traits<Debug>::binary).        */
+/*       Records are formatted as OStream would have done it, taking     */
+/*       string literals from the ELF images that produced the log.      */
+/*       Anything outside records is copied as is.                       */
+/*                                                                       */
+/* Parm: <ELF image> [<ELF image> ...] < <log>                           */
+/*=======================================================================*/
+
+// Using only bare C to avoid conflicts with EPOS
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <elf.h>
+
+// Constants (must match Binary_Debug in include/utility/debug.h)
+const unsigned char SYNC = 0xeb;
+
+enum {
+    LITERAL     = 'S',
+    STRING      = 's',
+    CHAR        = 'c',
+    SIGNED      = 'i',
+    UNSIGNED    = 'u',
+    POINTER     = 'p',
+    FLOAT       = 'f',
+    HEX         = 'h',
+    DEC         = 'd',
+    OCT         = 'o',
+    BIN         = 'b',
+    ENDL        = 'n'
+};
+
+const unsigned int MAX_SECTIONS = 64;
+
+// Types
+
+// Loaded sections of the images (where literals live)
+struct Section
+{
+    unsigned long long address;
+    unsigned long long size;
+    char * data;
+};
+
+// Prototypes
+bool load_image(const char * file);
+const char * literal(unsigned int id);
+void decode(const unsigned char * p, unsigned int size);
+void print_unsigned(unsigned long long v, bool negative);
+void print_float(float f);
+
+// Globals
+Section sections[MAX_SECTIONS];
+unsigned int n_sections = 0;
+unsigned int pointer_digits = 8;
+unsigned int base = 10;
+
+int main(int argc, char **argv)
+{
+    if(argc < 2) {
+        fprintf(stderr, "Usage: %s <ELF image> [<ELF image> ...] < <log>\n", argv[0]);
+        return 1;
+    }
+
+    for(int i = 1; i < argc; i++)
+        if(!load_image(argv[i]))
+            return 1;
+
+    int c;
+    while((c = getchar()) != EOF) {
+        if(c != SYNC) {
+            if(c != '\r')
+                putchar(c);
+            continue;
+        }
+
+        int size = getchar();
+        if(size == EOF)
+            break;
+
+        unsigned char record[256];
+        if(fread(record, 1, size, stdin) != static_cast<unsigned int>(size)) {
+            fprintf(stderr, "eposlog: truncated record at the end of the log\n");
+            break;
+        }
+
+        decode(record, size);
+    }
+
+    return 0;
+}
+
+template<typename Ehdr, typename Shdr>
+bool load_sections(FILE * file, const char * name)
+{
+    Ehdr ehdr;
+    if(fseek(file, 0, SEEK_SET) || (fread(&ehdr, sizeof(Ehdr), 1, file) != 1)) {
+        fprintf(stderr, "eposlog: can't read the ELF header of %s\n", name);
+        return false;
+    }
+
+    for(unsigned int i = 0; i < ehdr.e_shnum; i++) {
+        Shdr shdr;
+        if(fseek(file, ehdr.e_shoff + i * ehdr.e_shentsize, SEEK_SET) || (fread(&shdr, sizeof(Shdr), 1, file) != 1)) {
+            fprintf(stderr, "eposlog: can't read section %d of %s\n", i, name);
+            return false;
+        }
+
+        if((shdr.sh_type != SHT_PROGBITS) || !(shdr.sh_flags & SHF_ALLOC) || !shdr.sh_size)
+            continue;
+
+        if(n_sections == MAX_SECTIONS) {
+            fprintf(stderr, "eposlog: too many sections\n");
+            return false;
+        }
+
+        Section * s = &sections[n_sections];
+        s->address = shdr.sh_addr;
+        s->size = shdr.sh_size;
+        s->data = reinterpret_cast<char *>(malloc(s->size + 1));
+        if(!s->data || fseek(file, shdr.sh_offset, SEEK_SET) || (fread(s->data, 1, s->size, file) != s->size)) {
+            fprintf(stderr, "eposlog: can't read section %d of %s\n", i, name);
+            return false;
+        }
+        s->data[s->size] = '\0';
+        n_sections++;
+    }
+
+    return true;
+}
+
+bool load_image(const char * name)
+{
+    FILE * file = fopen(name, "rb");
+    if(!file) {
+        fprintf(stderr, "eposlog: can't open %s\n", name);
+        return false;
+    }
+
+    unsigned char ident[EI_NIDENT];
+    bool ok = (fread(ident, 1, EI_NIDENT, file) == EI_NIDENT) && !memcmp(ident, ELFMAG, SELFMAG) && (ident[EI_DATA] == ELFDATA2LSB);
+    if(!ok)
+        fprintf(stderr, "eposlog: %s is not a little-endian ELF image\n", name);
+    else if(ident[EI_CLASS] == ELFCLASS64) {
+        pointer_digits = 16;
+        ok = load_sections<Elf64_Ehdr, Elf64_Shdr>(file, name);
+    } else
+        ok = load_sections<Elf32_Ehdr, Elf32_Shdr>(file, name);
+
+    fclose(file);
+    return ok;
+}
+
+// Literals are identified by the lower 32 bits of their addresses
+const char * literal(unsigned int id)
+{
+    for(unsigned int i = 0; i < n_sections; i++) {
+        unsigned int offset = id - static_cast<unsigned int>(sections[i].address);
+        if(offset < sections[i].size)
+            return &sections[i].data[offset];
+    }
+    return 0;
+}
+
+unsigned long long varint(const unsigned char ** p, const unsigned char * end)
+{
+    unsigned long long v = 0;
+    for(unsigned int shift = 0; *p < end; shift += 7) {
+        unsigned char b = *(*p)++;
+        v |= static_cast<unsigned long long>(b & 0x7f) << shift;
+        if(!(b & 0x80))
+            break;
+    }
+    return v;
+}
+
+void decode(const unsigned char * p, unsigned int size)
+{
+    const unsigned char * end = p + size;
+
+    while(p < end) {
+        unsigned char tag = *p++;
+        switch(tag) {
+        case LITERAL: {
+            if(end - p < 4)
+                return;
+            unsigned int id = p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<unsigned int>(p[3]) << 24);
+            p += 4;
+            const char * s = literal(id);
+            if(s)
+                fputs(s, stdout);
+            else
+                printf("<literal %08x?>", id);
+        } break;
+        case STRING: {
+            unsigned int n = (p < end) ? *p++ : 0;
+            for(; n && (p < end); n--)
+                putchar(*p++);
+        } break;
+        case CHAR:
+            if(p < end)
+                putchar(*p++);
+            break;
+        case SIGNED: {
+            unsigned long long z = varint(&p, end);
+            long long v = static_cast<long long>(z >> 1) ^ -static_cast<long long>(z & 1);
+            print_unsigned((v < 0) ? -static_cast<unsigned long long>(v) : v, v < 0);
+        } break;
+        case UNSIGNED:
+            print_unsigned(varint(&p, end), false);
+            break;
+        case POINTER:
+            printf("0x%0*llx", pointer_digits, varint(&p, end));
+            break;
+        case FLOAT: {
+            if(end - p < 4)
+                return;
+            unsigned int u = p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<unsigned int>(p[3]) << 24);
+            p += 4;
+            float f;
+            memcpy(&f, &u, sizeof(float));
+            print_float(f);
+        } break;
+        case HEX: base = 16; break;
+        case DEC: base = 10; break;
+        case OCT: base = 8; break;
+        case BIN: base = 2; break;
+        case ENDL:
+            putchar('\n');
+            base = 10;
+            break;
+        default:
+            printf("<bad token %02x>", tag);
+            return;
+        }
+    }
+}
+
+// As OStream::utoa() (and friends)
+void print_unsigned(unsigned long long v, bool negative)
+{
+    if(negative)
+        putchar('-');
+
+    if(!v) {
+        putchar('0');
+        return;
+    }
+
+    if(v > 256) {
+        if(base == 8 || base == 16)
+            putchar('0');
+        if(base == 16)
+            putchar('x');
+    }
+
+    char digits[65];
+    int n = 0;
+    for(; v; v /= base)
+        digits[n++] = "0123456789abcdef"[v % base];
+    while(n)
+        putchar(digits[--n]);
+}
+
+// As OStream::operator<<(float)
+void print_float(float f)
+{
+    if(f < 0.0001f && f > -0.0001f) {
+        fputs("0.0000", stdout);
+        return;
+    }
+    if(f < 0) {
+        putchar('-');
+        f *= -1;
+    }
+
+    long long b = static_cast<long long>(f);
+    print_unsigned(b, false);
+    putchar('.');
+    print_unsigned(static_cast<long long>((f - b) * 10000), false);
+}